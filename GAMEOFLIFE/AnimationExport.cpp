@@ -0,0 +1,559 @@
+#include "AnimationExport.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+
+static const char RAWMAGIC[8] = { 'G', 'O', 'L', 'F', 'R', 'M', 'S', '1' };
+static const uint8_t PNGSIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+static constexpr int GIFMAXSIDE = 65535;
+
+AnimationFormat getAnimationFormat(const std::string& path) {
+    std::string extension = path.substr(path.find_last_of('.') == std::string::npos ? path.size() : path.find_last_of('.'));
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return (char)std::tolower((unsigned char)c); });
+    if (extension == ".gif")
+        return AnimationFormat::Gif;
+    if (extension == ".png" or extension == ".apng")
+        return AnimationFormat::Apng;
+    return AnimationFormat::Raw;
+}
+
+void chooseAnimationScale(int width, int height, int minSide, int maxSide, int& cellsPerPixel, int& pixelsPerCell) {
+    int side = std::max(width, height);
+    cellsPerPixel = 1;
+    while ((long long)cellsPerPixel * maxSide < side)
+        cellsPerPixel *= 2;
+    pixelsPerCell = side < minSide ? std::max(1, minSide / side) : 1;
+}
+
+static void putLittle16(std::vector<uint8_t>& out, uint32_t value) {
+    out.push_back((uint8_t)value);
+    out.push_back((uint8_t)(value >> 8));
+}
+
+static void putLittle32(std::vector<uint8_t>& out, uint32_t value) {
+    putLittle16(out, value & 0xFFFF);
+    putLittle16(out, value >> 16);
+}
+
+static void putBig32(std::vector<uint8_t>& out, uint32_t value) {
+    for (int shift = 24; shift >= 0; shift -= 8)
+        out.push_back((uint8_t)(value >> shift));
+}
+
+// LSB-first bit packing, shared by GIF codes and deflate.
+class BitPacker {
+private:
+    std::vector<uint8_t>& Out;
+    uint64_t Buffer;
+    int Count;
+
+public:
+    explicit BitPacker(std::vector<uint8_t>& out) : Out(out), Buffer(0), Count(0) {}
+
+    void put(uint32_t bits, int count) {
+        Buffer |= (uint64_t)bits << Count;
+        Count += count;
+        while (Count >= 8) {
+            Out.push_back((uint8_t)Buffer);
+            Buffer >>= 8;
+            Count -= 8;
+        }
+    }
+
+    // Huffman codes go most significant bit first.
+    void putReversed(uint32_t code, int count) {
+        uint32_t reversed = 0;
+        for (int i = 0; i < count; i++)
+            reversed |= ((code >> i) & 1) << (count - 1 - i);
+        put(reversed, count);
+    }
+
+    void flush() {
+        if (Count > 0)
+            Out.push_back((uint8_t)Buffer);
+        Buffer = 0;
+        Count = 0;
+    }
+};
+
+// GIF LZW over the pixel indexes 0 and 1, with the minimum code size 2 that
+// GIF requires. The dictionary is a trie of up to 4096 codes; once full, a
+// clear code starts it over.
+static void encodeLzw(const std::vector<uint8_t>& pixels, std::vector<uint8_t>& out) {
+    const int MINCODESIZE = 2, CLEAR = 1 << MINCODESIZE, END = CLEAR + 1;
+    static thread_local std::vector<int16_t> children;
+    children.assign(4096 * 2, -1);
+    BitPacker packer(out);
+    int codeSize = MINCODESIZE + 1, nextCode = END + 1;
+    packer.put(CLEAR, codeSize);
+    if (pixels.empty()) {
+        packer.put(END, codeSize);
+        packer.flush();
+        return;
+    }
+    int prefix = pixels[0];
+    for (size_t i = 1; i < pixels.size(); i++) {
+        int pixel = pixels[i];
+        int child = children[prefix * 2 + pixel];
+        if (child >= 0) {
+            prefix = child;
+            continue;
+        }
+        packer.put(prefix, codeSize);
+        children[prefix * 2 + pixel] = (int16_t)nextCode;
+        if (nextCode >= (1 << codeSize) and codeSize < 12)
+            codeSize++;
+        if (nextCode == 4095) {
+            packer.put(CLEAR, codeSize);
+            std::fill(children.begin(), children.end(), -1);
+            codeSize = MINCODESIZE + 1;
+            nextCode = END;
+        }
+        nextCode++;
+        prefix = pixel;
+    }
+    packer.put(prefix, codeSize);
+    packer.put(END, codeSize);
+    packer.flush();
+}
+
+// zlib stream of one fixed-Huffman deflate block. The only matches tried are
+// the byte before (runs) and the byte one row above (rows repeating the row
+// before), enough for boards that are mostly empty or periodic.
+static void deflateRows(const std::vector<uint8_t>& data, size_t stride, std::vector<uint8_t>& out) {
+    static const uint16_t LENGTHBASE[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    static const uint8_t LENGTHEXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+    static const uint16_t DISTANCEBASE[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+    static const uint8_t DISTANCEEXTRA[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+    out.push_back(0x78);
+    out.push_back(0x01);
+    BitPacker packer(out);
+    packer.put(1, 1); // last block
+    packer.put(1, 2); // fixed Huffman codes
+    auto putSymbol = [&packer](int symbol) {
+        if (symbol < 144)
+            packer.putReversed(0x30 + symbol, 8);
+        else if (symbol < 256)
+            packer.putReversed(0x190 + symbol - 144, 9);
+        else if (symbol < 280)
+            packer.putReversed(symbol - 256, 7);
+        else
+            packer.putReversed(0xC0 + symbol - 280, 8);
+    };
+    size_t distances[2] = { 1, stride <= 32768 ? stride : 0 };
+    size_t size = data.size();
+    for (size_t i = 0; i < size; ) {
+        size_t bestLength = 0, bestDistance = 0;
+        for (size_t distance : distances) {
+            if (distance == 0 or i < distance)
+                continue;
+            size_t length = 0;
+            while (length < 258 and i + length < size and data[i + length] == data[i + length - distance])
+                length++;
+            if (length > bestLength) {
+                bestLength = length;
+                bestDistance = distance;
+            }
+        }
+        if (bestLength < 3) {
+            putSymbol(data[i++]);
+            continue;
+        }
+        int code = 28;
+        while (LENGTHBASE[code] > bestLength)
+            code--;
+        putSymbol(257 + code);
+        packer.put((uint32_t)(bestLength - LENGTHBASE[code]), LENGTHEXTRA[code]);
+        code = 29;
+        while (DISTANCEBASE[code] > bestDistance)
+            code--;
+        packer.putReversed(code, 5);
+        packer.put((uint32_t)(bestDistance - DISTANCEBASE[code]), DISTANCEEXTRA[code]);
+        i += bestLength;
+    }
+    putSymbol(256);
+    packer.flush();
+    uint32_t a = 1, b = 0;
+    for (uint8_t byte : data) {
+        a = (a + byte) % 65521;
+        b = (b + a) % 65521;
+    }
+    putBig32(out, (b << 16) | a);
+}
+
+static std::vector<uint32_t> makeCrcTable() {
+    std::vector<uint32_t> table(256);
+    for (uint32_t n = 0; n < 256; n++) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++)
+            c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        table[n] = c;
+    }
+    return table;
+}
+
+static uint32_t crc32(const uint8_t* data, size_t size) {
+    static const std::vector<uint32_t> table = makeCrcTable();
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; i++)
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFFu;
+}
+
+// Length, type, data and the CRC of type and data.
+static void putPngChunk(std::vector<uint8_t>& out, const char* type, const uint8_t* data, size_t size) {
+    putBig32(out, (uint32_t)size);
+    size_t start = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data, data + size);
+    putBig32(out, crc32(out.data() + start, size + 4));
+}
+
+AnimationWriter::AnimationWriter(size_t capacity) : Capacity(std::max<size_t>(1, capacity)), Blocking(false), Accepting(false), Finishing(false), Active(false), Stopping(false), Failed(false),
+                                                    Written(0), Dropped(0), Format(AnimationFormat::Raw), Width(0), Height(0), CellsPerPixel(1), PixelsPerCell(1), DelayMillis(100), Sequence(0) {
+    Worker = std::thread(&AnimationWriter::workerLoop, this);
+}
+
+AnimationWriter::~AnimationWriter() {
+    finish();
+    {
+        std::lock_guard<std::mutex> lock(Mutex);
+        Stopping = true;
+    }
+    WakeUp.notify_all();
+    Worker.join();
+}
+
+bool AnimationWriter::open(const std::string& path, int width, int height, int cellsPerPixel, int pixelsPerCell, int delayMillis) {
+    std::unique_lock<std::mutex> lock(Mutex);
+    Idle.wait(lock, [this] { return !Active; });
+    CellsPerPixel = std::max(1, cellsPerPixel);
+    Width = (width + CellsPerPixel - 1) / CellsPerPixel;
+    Height = (height + CellsPerPixel - 1) / CellsPerPixel;
+    Format = getAnimationFormat(path);
+    // Raw streams are never enlarged, GIF cannot be larger than 65535 pixels.
+    PixelsPerCell = Format == AnimationFormat::Raw ? 1 : std::max(1, pixelsPerCell);
+    if (Format == AnimationFormat::Gif)
+        PixelsPerCell = std::min(PixelsPerCell, GIFMAXSIDE / std::max(1, std::max(Width, Height)));
+    if (PixelsPerCell < 1 or Width <= 0 or Height <= 0)
+        return false;
+    DelayMillis = std::max(0, delayMillis);
+    Path = path;
+    File.open(path, std::ios::binary | std::ios::trunc);
+    if (!File or !writeHeader()) {
+        File.close();
+        return false;
+    }
+    Written = 0;
+    Dropped = 0;
+    Failed = false;
+    Accepting = Active = true;
+    return true;
+}
+
+// Bits 0, 2, 4 ... 62 of the word as its low 32 bits.
+static uint64_t takeEvenBits(uint64_t word) {
+    word &= 0x5555555555555555ULL;
+    word = (word | (word >> 1)) & 0x3333333333333333ULL;
+    word = (word | (word >> 2)) & 0x0F0F0F0F0F0F0F0FULL;
+    word = (word | (word >> 4)) & 0x00FF00FF00FF00FFULL;
+    word = (word | (word >> 8)) & 0x0000FFFF0000FFFFULL;
+    return (word | (word >> 16)) & 0x00000000FFFFFFFFULL;
+}
+
+// The board is shrunk on the caller's thread: the queued copy is then no
+// larger than the image. A board of another size than the file was opened
+// for is cut off or padded.
+void AnimationWriter::downscale(const BitBoard& board, BitBoard& pixels) {
+    if (CellsPerPixel == 1 and board.getWidth() == Width and board.getHeight() == Height) {
+        pixels = board;
+        return;
+    }
+    if (pixels.getWidth() != Width or pixels.getHeight() != Height)
+        pixels.resize(Height, Width);
+    pixels.clear();
+    // Zero words after the row, so the last block never reads past it.
+    int words = board.getWordsPerRow();
+    MergedRow.resize(std::max(words, pixels.getWordsPerRow() * CellsPerPixel) + CellsPerPixel / 64 + 2);
+    for (int py = 0; py < Height; py++) {
+        std::fill(MergedRow.begin(), MergedRow.end(), 0);
+        uint64_t any = 0;
+        for (int y = py * CellsPerPixel; y < std::min(board.getHeight(), (py + 1) * CellsPerPixel); y++) {
+            const uint64_t* row = board.row(y);
+            for (int i = 0; i < words; i++) {
+                MergedRow[i] |= row[i];
+                any |= row[i];
+            }
+        }
+        if (!any)
+            continue;
+        // A pixel is set when any cell of its block is alive. Blocks of up to
+        // a word are smeared first, after which bit x holds the OR of cells
+        // x ... x + CellsPerPixel - 1, and only the first bit of each block is
+        // read; for a power of two by halving the row until one bit is left.
+        uint64_t* pixelRow = pixels.row(py);
+        if (CellsPerPixel <= 64) {
+            for (int span = 1; span < CellsPerPixel; ) {
+                int shift = std::min(span, CellsPerPixel - span);
+                for (size_t i = 0; i + 1 < MergedRow.size(); i++)
+                    MergedRow[i] |= (MergedRow[i] >> shift) | (MergedRow[i + 1] << (64 - shift));
+                span += shift;
+            }
+            if ((CellsPerPixel & (CellsPerPixel - 1)) == 0) {
+                size_t count = MergedRow.size();
+                for (int stride = 1; stride < CellsPerPixel; stride *= 2, count = (count + 1) / 2)
+                    for (size_t i = 0; i < count; i += 2)
+                        MergedRow[i / 2] = takeEvenBits(MergedRow[i]) | (i + 1 < count ? takeEvenBits(MergedRow[i + 1]) << 32 : 0);
+                int pixelWords = pixels.getWordsPerRow();
+                std::copy(MergedRow.begin(), MergedRow.begin() + pixelWords, pixelRow);
+                pixelRow[pixelWords - 1] &= pixels.getLastWordMask();
+                continue;
+            }
+            const uint64_t* merged = MergedRow.data();
+            for (int x = 0, start = 0; x < Width; x += 64) {
+                uint64_t word = 0;
+                for (int bit = 0; bit < 64 and x + bit < Width; bit++, start += CellsPerPixel)
+                    word |= ((merged[start >> 6] >> (start & 63)) & 1) << bit;
+                pixelRow[x >> 6] = word;
+            }
+            continue;
+        }
+        for (int x = 0, start = 0; x < Width; x++, start += CellsPerPixel) {
+            int end = start + CellsPerPixel;
+            for (int word = start >> 6; word <= (end - 1) >> 6; word++) {
+                uint64_t bits = MergedRow[word];
+                if (word == start >> 6)
+                    bits &= ~0ULL << (start & 63);
+                if (word == (end - 1) >> 6 and (end & 63) != 0)
+                    bits &= (1ULL << (end & 63)) - 1;
+                if (bits) {
+                    pixelRow[x >> 6] |= 1ULL << (x & 63);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+bool AnimationWriter::push(const BitBoard& board, long long generation) {
+    BitBoard pixels;
+    {
+        std::unique_lock<std::mutex> lock(Mutex);
+        if (!Accepting)
+            return false;
+        if (Blocking)
+            Space.wait(lock, [this] { return Queue.size() < Capacity; });
+        else if (Queue.size() >= Capacity) {
+            Dropped++;
+            return false;
+        }
+        if (!Spare.empty()) {
+            pixels.swap(Spare.back());
+            Spare.pop_back();
+        }
+    }
+    downscale(board, pixels);
+    {
+        std::lock_guard<std::mutex> lock(Mutex);
+        Queue.push_back(Frame());
+        Queue.back().Pixels.swap(pixels);
+        Queue.back().Generation = generation;
+    }
+    WakeUp.notify_all();
+    return true;
+}
+
+void AnimationWriter::finish() {
+    {
+        std::lock_guard<std::mutex> lock(Mutex);
+        if (!Accepting)
+            return;
+        Accepting = false;
+        Finishing = true;
+    }
+    WakeUp.notify_all();
+    Space.notify_all();
+}
+
+bool AnimationWriter::wait() {
+    std::unique_lock<std::mutex> lock(Mutex);
+    Idle.wait(lock, [this] { return !Active; });
+    return !Failed;
+}
+
+void AnimationWriter::workerLoop() {
+    std::unique_lock<std::mutex> lock(Mutex);
+    while (true) {
+        WakeUp.wait(lock, [this] { return !Queue.empty() or Finishing or Stopping; });
+        if (!Queue.empty()) {
+            Frame frame = std::move(Queue.front());
+            Queue.pop_front();
+            lock.unlock();
+            Space.notify_all();
+            bool written = writeFrame(frame);
+            lock.lock();
+            Failed = Failed or !written;
+            Written++;
+            Spare.push_back(std::move(frame.Pixels));
+            continue;
+        }
+        if (Finishing) {
+            lock.unlock();
+            bool written = writeTrailer();
+            File.close();
+            if (Format == AnimationFormat::Apng and Written.load() == 0)
+                std::remove(Path.c_str());
+            lock.lock();
+            Failed = Failed or !written or File.fail();
+            Finishing = false;
+            Active = false;
+            Idle.notify_all();
+            continue;
+        }
+        return;
+    }
+}
+
+bool AnimationWriter::writeHeader() {
+    int width = Width * PixelsPerCell, height = Height * PixelsPerCell;
+    if (Format == AnimationFormat::Gif) {
+        const char* signature = "GIF89a";
+        Encoded.assign(signature, signature + 6);
+        putLittle16(Encoded, width);
+        putLittle16(Encoded, height);
+        uint8_t screen[3] = { 0x80, 0, 0 }; // global table of two colors
+        uint8_t colors[6] = { 0, 0, 0, 255, 255, 255 };
+        Encoded.insert(Encoded.end(), screen, screen + 3);
+        Encoded.insert(Encoded.end(), colors, colors + 6);
+        const uint8_t loop[19] = { 0x21, 0xFF, 11, 'N', 'E', 'T', 'S', 'C', 'A', 'P', 'E', '2', '.', '0', 3, 1, 0, 0, 0 };
+        Encoded.insert(Encoded.end(), loop, loop + sizeof(loop));
+    }
+    else if (Format == AnimationFormat::Apng) {
+        Encoded.assign(PNGSIGNATURE, PNGSIGNATURE + 8);
+        std::vector<uint8_t> header;
+        putBig32(header, width);
+        putBig32(header, height);
+        const uint8_t format[5] = { 1, 0, 0, 0, 0 }; // 1-bit grayscale, no interlace
+        header.insert(header.end(), format, format + 5);
+        putPngChunk(Encoded, "IHDR", header.data(), header.size());
+        // The frame count is patched in by writeTrailer().
+        FrameCountOffset = (std::streamoff)Encoded.size();
+        const uint8_t control[8] = { 0 };
+        putPngChunk(Encoded, "acTL", control, 8);
+        Sequence = 0;
+    }
+    else {
+        Encoded.assign(RAWMAGIC, RAWMAGIC + 8);
+        putLittle32(Encoded, Width);
+        putLittle32(Encoded, Height);
+        putLittle32(Encoded, CellsPerPixel);
+    }
+    return (bool)File.write((const char*)Encoded.data(), Encoded.size());
+}
+
+bool AnimationWriter::writeFrame(const Frame& frame) {
+    const BitBoard& pixels = frame.Pixels;
+    int width = Width * PixelsPerCell, height = Height * PixelsPerCell;
+    Encoded.clear();
+    if (Format == AnimationFormat::Gif) {
+        int delay = (DelayMillis + 5) / 10;
+        const uint8_t control[8] = { 0x21, 0xF9, 4, 0, (uint8_t)delay, (uint8_t)(delay >> 8), 0, 0 };
+        Encoded.insert(Encoded.end(), control, control + 8);
+        Encoded.push_back(0x2C);
+        putLittle32(Encoded, 0);
+        putLittle16(Encoded, width);
+        putLittle16(Encoded, height);
+        Encoded.push_back(0);
+        Encoded.push_back(2); // minimum code size
+        // Each row of cells once, then repeated for the enlargement.
+        std::vector<uint8_t> indexes((size_t)width * height);
+        for (int y = 0; y < Height; y++) {
+            uint8_t* row = &indexes[(size_t)y * PixelsPerCell * width];
+            for (int x = 0; x < Width; x++)
+                std::fill(row + x * PixelsPerCell, row + (x + 1) * PixelsPerCell, (uint8_t)pixels.get(x, y));
+            for (int copy = 1; copy < PixelsPerCell; copy++)
+                std::copy(row, row + width, row + (size_t)copy * width);
+        }
+        std::vector<uint8_t> codes;
+        encodeLzw(indexes, codes);
+        for (size_t i = 0; i < codes.size(); i += 255) {
+            size_t count = std::min<size_t>(255, codes.size() - i);
+            Encoded.push_back((uint8_t)count);
+            Encoded.insert(Encoded.end(), codes.begin() + i, codes.begin() + i + count);
+        }
+        Encoded.push_back(0);
+    }
+    else if (Format == AnimationFormat::Apng) {
+        std::vector<uint8_t> control;
+        putBig32(control, Sequence++);
+        putBig32(control, width);
+        putBig32(control, height);
+        putBig32(control, 0);
+        putBig32(control, 0);
+        control.push_back((uint8_t)(DelayMillis >> 8));
+        control.push_back((uint8_t)DelayMillis);
+        control.push_back(1000 >> 8);
+        control.push_back(1000 & 0xFF);
+        control.push_back(0); // leave the frame as it is
+        control.push_back(0); // replace, not blend
+        putPngChunk(Encoded, "fcTL", control.data(), control.size());
+        // Each row: filter type 0, then the pixels, the first in the high bit.
+        size_t stride = 1 + ((size_t)width + 7) / 8;
+        std::vector<uint8_t> rows(stride * height);
+        for (int y = 0; y < Height; y++) {
+            uint8_t* row = &rows[(size_t)y * PixelsPerCell * stride];
+            for (int x = 0, px = 0; x < Width; x++) {
+                bool alive = pixels.get(x, y);
+                for (int repeat = 0; repeat < PixelsPerCell; repeat++, px++)
+                    if (alive)
+                        row[1 + (px >> 3)] |= (uint8_t)(0x80 >> (px & 7));
+            }
+            for (int copy = 1; copy < PixelsPerCell; copy++)
+                std::copy(row, row + stride, row + (size_t)copy * stride);
+        }
+        // The first frame is the default image, the others carry a sequence number.
+        bool first = Sequence == 1;
+        std::vector<uint8_t> data;
+        if (!first)
+            putBig32(data, Sequence++);
+        deflateRows(rows, stride, data);
+        putPngChunk(Encoded, first ? "IDAT" : "fdAT", data.data(), data.size());
+    }
+    else {
+        uint8_t generation[8];
+        for (int i = 0; i < 8; i++)
+            generation[i] = (uint8_t)((uint64_t)frame.Generation >> (8 * i));
+        Encoded.insert(Encoded.end(), generation, generation + 8);
+        size_t rowBytes = ((size_t)Width + 7) / 8;
+        for (int y = 0; y < Height; y++) {
+            const uint8_t* row = (const uint8_t*)pixels.row(y); // little-endian words
+            Encoded.insert(Encoded.end(), row, row + rowBytes);
+        }
+    }
+    return (bool)File.write((const char*)Encoded.data(), Encoded.size());
+}
+
+bool AnimationWriter::writeTrailer() {
+    if (Format == AnimationFormat::Gif) {
+        File.put(0x3B);
+        return (bool)File;
+    }
+    if (Format == AnimationFormat::Apng) {
+        // Without a single frame there is no image data and the file is not a
+        // PNG at all; it is removed once closed.
+        if (Written.load() == 0)
+            return false;
+        Encoded.clear();
+        putPngChunk(Encoded, "IEND", nullptr, 0);
+        File.write((const char*)Encoded.data(), Encoded.size());
+        std::vector<uint8_t> control, chunk;
+        putBig32(control, (uint32_t)Written.load());
+        putBig32(control, 0); // loop forever
+        putPngChunk(chunk, "acTL", control.data(), control.size());
+        File.seekp(FrameCountOffset);
+        File.write((const char*)chunk.data(), chunk.size());
+        return (bool)File;
+    }
+    return (bool)File;
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "BitBoard.h"
+
+// Animation of a run, one image per recorded generation, live cells white on
+// black. GIF is LZW-compressed; APNG is deflated with runs and repeated rows
+// as the only matches, which is what a Life board consists of. The raw stream
+// is for other programs: the magic "GOLFRMS1", then width, height and cells
+// per pixel as little-endian uint32, then per frame the generation as int64
+// and the rows, each padded to whole bytes, bit (x & 7) of byte (x >> 3)
+// being pixel x.
+enum class AnimationFormat { Gif, Apng, Raw };
+
+// By extension: .gif, .png or .apng, anything else is a raw stream.
+AnimationFormat getAnimationFormat(const std::string& path);
+
+// A board larger than maxSide on either side is shrunk by a power of two
+// cells per pixel, the fastest to downscale; a smaller one is enlarged up to
+// minSide pixels by a whole number of pixels per cell.
+void chooseAnimationScale(int width, int height, int minSide, int maxSide, int& cellsPerPixel, int& pixelsPerCell);
+
+// Encodes frames on its own thread. push() only downscales the board into a
+// queued frame, so the stepping loop never waits for compression or the disk:
+// when the queue is full the frame is dropped and counted, unless blocking was
+// asked for. Like CheckpointWriter, one thread serves one file after another.
+class AnimationWriter {
+private:
+    struct Frame {
+        BitBoard Pixels;
+        long long Generation;
+    };
+
+    std::thread Worker;
+    std::mutex Mutex;
+    std::condition_variable WakeUp; // worker: frames queued or the file finished
+    std::condition_variable Space;  // producer: a frame was taken off the queue
+    std::condition_variable Idle;   // open() and wait(): the file is closed
+    std::deque<Frame> Queue;
+    std::vector<BitBoard> Spare;    // pixel buffers of encoded frames, for reuse
+    size_t Capacity;
+    bool Blocking;
+    bool Accepting, Finishing, Active, Stopping;
+    bool Failed;
+    std::atomic<long long> Written, Dropped;
+
+    // Producer side.
+    std::vector<uint64_t> MergedRow;
+
+    // Worker side, besides the file header written by open().
+    std::ofstream File;
+    std::string Path;
+    AnimationFormat Format;
+    int Width, Height; // in pixels, before the enlargement
+    int CellsPerPixel, PixelsPerCell, DelayMillis;
+    uint32_t Sequence;               // APNG chunk sequence number
+    std::streampos FrameCountOffset; // APNG frame count, known only at the end
+    std::vector<uint8_t> Encoded;
+
+    void workerLoop();
+    void downscale(const BitBoard& board, BitBoard& pixels);
+    bool writeHeader();
+    bool writeFrame(const Frame& frame);
+    bool writeTrailer();
+
+public:
+    explicit AnimationWriter(size_t capacity = 64);
+    ~AnimationWriter();
+
+    AnimationWriter(const AnimationWriter&) = delete;
+    AnimationWriter& operator=(const AnimationWriter&) = delete;
+
+    // Starts a file for boards of width x height cells, waiting for the
+    // previous one to be finished. delayMillis is the time each frame shows.
+    bool open(const std::string& path, int width, int height, int cellsPerPixel, int pixelsPerCell, int delayMillis);
+
+    // Blocking push() waits for room in the queue instead of dropping the frame.
+    void setBlocking(bool blocking) { Blocking = blocking; }
+
+    // Queues the board; false when it was dropped or no file is open.
+    bool push(const BitBoard& board, long long generation);
+
+    // No more frames; the rest of the queue and the end of the file are written
+    // in the background.
+    void finish();
+
+    // Waits until the file is complete. False if anything could not be written,
+    // or if an APNG got no frame, there being no image to make a PNG of.
+    bool wait();
+
+    bool isOpen() {
+        std::lock_guard<std::mutex> lock(Mutex);
+        return Accepting;
+    }
+
+    const std::string& getPath() const { return Path; }
+
+    long long getFramesWritten() const { return Written.load(std::memory_order_relaxed); }
+
+    long long getFramesDropped() const { return Dropped.load(std::memory_order_relaxed); }
+};
@@ -0,0 +1,205 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include "GameOfLife.h"
+
+// Throughput benchmark of GameOfLife::iterate(). Every case is a fixed board
+// (a canonical pattern in the middle of an empty torus, or a soup from a fixed
+// seed), stepped for a number of generations that depends only on the board
+// size, so two builds run exactly the same work and their results can be diffed.
+//
+//   gameoflife-bench [--format json|csv] [--output file] [--max-size N]
+//                    [--threads 1,2,4] [--kernel name] [--work cell-updates]
+
+struct BenchmarkPattern {
+    const char* Name;
+    const char* Cells;  // rows separated by '/', 'O' is a live cell
+    int Density;        // percent of live cells for soups, Cells is empty then
+};
+
+static const BenchmarkPattern PATTERNS[] = {
+    { "r-pentomino", ".OO/OO./.O.", 0 },
+    { "acorn", ".O...../...O.../OO..OOO", 0 },
+    { "gosper-gun",
+      "........................O.........../"
+      "......................O.O.........../"
+      "............OO......OO............OO/"
+      "...........O...O....OO............OO/"
+      "OO........O.....O...OO............../"
+      "OO........O...O.OO....O.O.........../"
+      "..........O.....O.......O.........../"
+      "...........O...O..................../"
+      "............OO......................", 0 },
+    { "dense-random", "", 50 },
+    { "sparse-random", "", 5 },
+};
+
+// Height and width of the boards.
+static const int SIZES[][2] = { { 100, 200 }, { 1024, 1024 }, { 4096, 4096 }, { 16384, 16384 } };
+
+static const unsigned SEED = 20240601;
+
+struct BenchmarkResult {
+    std::string Pattern;
+    int Width, Height, Threads;
+    const char* Kernel;
+    long long Generations;
+    double Seconds;
+    size_t MemoryBytes;
+    long long Population;
+    double Speedup;
+};
+
+static BitBoard makeBoard(const BenchmarkPattern& pattern, int height, int width) {
+    BitBoard board(height, width);
+    if (pattern.Density > 0) {
+        // Raw mt19937 output is specified by the standard, unlike the distributions.
+        std::mt19937 generator(SEED);
+        for (int y = 0; y < height; y++)
+            for (int x = 0; x < width; x++)
+                board.set(x, y, generator() % 100 < (unsigned)pattern.Density);
+        return board;
+    }
+    int patternWidth = (int)(std::strchr(pattern.Cells, '/') - pattern.Cells);
+    int patternHeight = (int)std::count(pattern.Cells, pattern.Cells + std::strlen(pattern.Cells), '/') + 1;
+    int x0 = (width - patternWidth) / 2, y0 = (height - patternHeight) / 2;
+    int x = 0, y = 0;
+    for (const char* c = pattern.Cells; *c != '\0'; c++) {
+        if (*c == '/') {
+            x = 0;
+            y++;
+            continue;
+        }
+        if (*c == 'O')
+            board.set(x0 + x, y0 + y, true);
+        x++;
+    }
+    return board;
+}
+
+static BenchmarkResult runCase(const BenchmarkPattern& pattern, int height, int width, int threads, KernelKind kernel, double work) {
+    GameOfLife life(height, width);
+    life.setBoard(makeBoard(pattern, height, width));
+    life.setKernel(kernel);
+    life.setThreadCount(threads);
+    long long generations = std::max(4LL, std::min(10000LL, (long long)(work / ((double)width * height))));
+    life.iterate(); // the first generation steps every tile, later ones only the active ones
+    auto start = std::chrono::steady_clock::now();
+    for (long long i = 0; i < generations; i++)
+        life.iterate();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    BenchmarkResult result = { pattern.Name, width, height, life.getThreadCount(), getKernelName(life.getKernel()),
+                               generations, seconds, life.getMemoryUsage(), life.getPopulation(), 1.0 };
+    return result;
+}
+
+static std::vector<int> parseThreadList(const char* text) {
+    std::vector<int> threads;
+    while (*text != '\0') {
+        char* end;
+        long count = std::strtol(text, &end, 10);
+        if (end == text or count < 1 or count > 1024)
+            return std::vector<int>();
+        threads.push_back((int)count);
+        text = *end == ',' ? end + 1 : end;
+    }
+    return threads;
+}
+
+static void writeResults(FILE* out, const std::vector<BenchmarkResult>& results, bool csv) {
+    if (csv)
+        std::fprintf(out, "pattern,width,height,kernel,threads,generations,seconds,cell_updates_per_second,ns_per_generation,memory_bytes,population,speedup\n");
+    else
+        std::fprintf(out, "[\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchmarkResult& r = results[i];
+        double cellUpdates = (double)r.Width * r.Height * r.Generations;
+        double updatesPerSecond = r.Seconds > 0 ? cellUpdates / r.Seconds : 0.0;
+        double nsPerGeneration = r.Seconds * 1e9 / r.Generations;
+        if (csv)
+            std::fprintf(out, "%s,%d,%d,%s,%d,%lld,%.6f,%.0f,%.0f,%zu,%lld,%.3f\n", r.Pattern.c_str(), r.Width, r.Height, r.Kernel, r.Threads,
+                         r.Generations, r.Seconds, updatesPerSecond, nsPerGeneration, r.MemoryBytes, r.Population, r.Speedup);
+        else
+            std::fprintf(out, "  {\"pattern\": \"%s\", \"width\": %d, \"height\": %d, \"kernel\": \"%s\", \"threads\": %d, \"generations\": %lld, "
+                              "\"seconds\": %.6f, \"cell_updates_per_second\": %.0f, \"ns_per_generation\": %.0f, \"memory_bytes\": %zu, "
+                              "\"population\": %lld, \"speedup\": %.3f}%s\n", r.Pattern.c_str(), r.Width, r.Height, r.Kernel, r.Threads,
+                         r.Generations, r.Seconds, updatesPerSecond, nsPerGeneration, r.MemoryBytes, r.Population, r.Speedup,
+                         i + 1 < results.size() ? "," : "");
+    }
+    if (!csv)
+        std::fprintf(out, "]\n");
+}
+
+int main(int argc, char** argv) {
+    bool csv = false;
+    const char* outputPath = nullptr;
+    int maxSize = 16384;
+    double work = 4e8;
+    KernelKind kernel = detectBestKernel();
+    std::vector<int> threadCounts;
+    int hardwareThreads = std::max(1, (int)std::thread::hardware_concurrency());
+    for (int threads = 1; threads < hardwareThreads; threads *= 2)
+        threadCounts.push_back(threads);
+    threadCounts.push_back(hardwareThreads);
+
+    if (argc % 2 == 0) {
+        std::fprintf(stderr, "Missing value for %s\n", argv[argc - 1]);
+        return 1;
+    }
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string option = argv[i];
+        const char* value = argv[i + 1];
+        if (option == "--format" and (std::strcmp(value, "json") == 0 or std::strcmp(value, "csv") == 0))
+            csv = std::strcmp(value, "csv") == 0;
+        else if (option == "--output")
+            outputPath = value;
+        else if (option == "--max-size" and std::atoi(value) > 0)
+            maxSize = std::atoi(value);
+        else if (option == "--work" and std::atof(value) > 0)
+            work = std::atof(value);
+        else if (option == "--kernel" and parseKernelName(value, kernel) and isKernelSupported(kernel))
+            continue;
+        else if (option == "--threads" and !parseThreadList(value).empty())
+            threadCounts = parseThreadList(value);
+        else {
+            std::fprintf(stderr, "Invalid option %s %s\n", option.c_str(), value);
+            return 1;
+        }
+    }
+
+    std::vector<BenchmarkResult> results;
+    for (const BenchmarkPattern& pattern : PATTERNS) {
+        for (const auto& size : SIZES) {
+            if (size[0] > maxSize or size[1] > maxSize)
+                continue;
+            // Speedup is relative to the first thread count of the list.
+            double baseSeconds = 0;
+            for (size_t i = 0; i < threadCounts.size(); i++) {
+                BenchmarkResult result = runCase(pattern, size[0], size[1], threadCounts[i], kernel, work);
+                if (i == 0)
+                    baseSeconds = result.Seconds;
+                result.Speedup = result.Seconds > 0 ? baseSeconds / result.Seconds : 0.0;
+                std::fprintf(stderr, "%-14s %5d x %-5d %2d threads %10.0f ns/generation\n", result.Pattern.c_str(), result.Width, result.Height,
+                             result.Threads, result.Seconds * 1e9 / result.Generations);
+                results.push_back(result);
+            }
+        }
+    }
+
+    FILE* out = outputPath ? std::fopen(outputPath, "w") : stdout;
+    if (!out) {
+        std::fprintf(stderr, "Cannot write %s\n", outputPath);
+        return 1;
+    }
+    writeResults(out, results, csv);
+    if (out != stdout)
+        std::fclose(out);
+    return 0;
+}
@@ -0,0 +1,134 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+
+// Population count of a single 64-bit word.
+inline int popcount64(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(word);
+#else
+    word = word - ((word >> 1) & 0x5555555555555555ULL);
+    word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+    word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (int)((word * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+// Index of the lowest set bit of a non-zero word.
+inline int countTrailingZeros64(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(word);
+#else
+    return popcount64((word & (0 - word)) - 1);
+#endif
+}
+
+// Board of Width x Height cells packed 64 per uint64_t.
+// Rows are padded to a whole number of words; bit (x & 63) of word (x >> 6)
+// holds cell x. Padding bits are always zero. Around the cells lies a border
+// of ghost cells for the stepping kernels: a word before and after every row,
+// row(y)[-1] and row(y)[getWordsPerRow()], and a row above and below the
+// board, row(-1) and row(getHeight()). fillGhostCells() (see LifeKernel.h)
+// fills them from the board before a step; nothing else reads them, and they
+// take no part in comparisons and counts.
+class BitBoard {
+private:
+    int Width, Height, WordsPerRow;
+    std::vector<uint64_t> Words;
+
+    // Words from one row to the next, the two ghost words included.
+    size_t getStride() const { return (size_t)WordsPerRow + 2; }
+
+public:
+    BitBoard() : Width(0), Height(0), WordsPerRow(0) {}
+
+    BitBoard(int height, int width) : Width(0), Height(0), WordsPerRow(0) { resize(height, width); }
+
+    int getWidth() const { return Width; }
+
+    int getHeight() const { return Height; }
+
+    int getWordsPerRow() const { return WordsPerRow; }
+
+    // Mask of the bits of the last word of a row that belong to the board.
+    uint64_t getLastWordMask() const {
+        int usedBits = Width - (WordsPerRow - 1) * 64;
+        return usedBits == 64 ? ~0ULL : (1ULL << usedBits) - 1;
+    }
+
+    // Valid from -1 to Height, the ghost rows; each row from word -1 to WordsPerRow.
+    uint64_t* row(int y) { return Words.data() + (size_t)(y + 1) * getStride() + 1; }
+
+    const uint64_t* row(int y) const { return Words.data() + (size_t)(y + 1) * getStride() + 1; }
+
+    bool get(int x, int y) const { return (row(y)[x >> 6] >> (x & 63)) & 1; }
+
+    void set(int x, int y, bool value) {
+        uint64_t bit = 1ULL << (x & 63);
+        value ? row(y)[x >> 6] |= bit : row(y)[x >> 6] &= ~bit;
+    }
+
+    void toggle(int x, int y) { row(y)[x >> 6] ^= 1ULL << (x & 63); }
+
+    // Sets cells [x, x + length) of row y, a word at a time.
+    void setRun(int x, int y, int length) {
+        uint64_t* words = row(y);
+        int end = x + length;
+        while (x < end) {
+            int bit = x & 63;
+            int count = std::min(64 - bit, end - x);
+            uint64_t mask = count == 64 ? ~0ULL : ((1ULL << count) - 1) << bit;
+            words[x >> 6] |= mask;
+            x += count;
+        }
+    }
+
+    void clear() { std::fill(Words.begin(), Words.end(), 0); }
+
+    int countPopulation() const {
+        int population = 0;
+        for (int y = 0; y < Height; y++)
+            for (int i = 0; i < WordsPerRow; i++)
+                population += popcount64(row(y)[i]);
+        return population;
+    }
+
+    // Changes the dimensions, keeping the cells that fit into the new board.
+    void resize(int newHeight, int newWidth) {
+        BitBoard resized;
+        resized.Width = newWidth;
+        resized.Height = newHeight;
+        resized.WordsPerRow = (newWidth + 63) / 64;
+        resized.Words.assign(((size_t)newHeight + 2) * resized.getStride(), 0);
+        int keptRows = std::min(Height, newHeight);
+        int keptWords = std::min(WordsPerRow, resized.WordsPerRow);
+        for (int y = 0; y < keptRows; y++)
+            std::copy(row(y), row(y) + keptWords, resized.row(y));
+        if (resized.WordsPerRow > 0)
+            for (int y = 0; y < keptRows; y++)
+                resized.row(y)[resized.WordsPerRow - 1] &= resized.getLastWordMask();
+        swap(resized);
+    }
+
+    size_t getMemoryUsage() const { return Words.capacity() * sizeof(uint64_t); }
+
+    void swap(BitBoard& other) {
+        std::swap(Width, other.Width);
+        std::swap(Height, other.Height);
+        std::swap(WordsPerRow, other.WordsPerRow);
+        Words.swap(other.Words);
+    }
+
+    bool operator==(const BitBoard& other) const {
+        if (Width != other.Width or Height != other.Height)
+            return false;
+        for (int y = 0; y < Height; y++)
+            if (!std::equal(row(y), row(y) + WordsPerRow, other.row(y)))
+                return false;
+        return true;
+    }
+
+    bool operator!=(const BitBoard& other) const { return !(*this == other); }
+};
@@ -0,0 +1,86 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+#include "BitBoard.h"
+
+// Zobrist key of the cell with the given index (y * width + x). The keys are
+// derived with splitmix64 instead of being stored, so boards of any size need
+// no key table. The hash of a board is the XOR of the keys of its live cells,
+// which lets it be updated by XOR-ing in only the cells that flipped.
+inline uint64_t zobristKey(uint64_t cell) {
+    uint64_t z = cell * 0x9E3779B97F4A7C15ULL + 0x632BE59BD9B4E019ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// XOR of the keys of the set bits of word, word being cells [firstCell, firstCell + 64).
+inline uint64_t hashWord(uint64_t word, uint64_t firstCell) {
+    uint64_t hash = 0;
+    while (word) {
+        hash ^= zobristKey(firstCell + countTrailingZeros64(word));
+        word &= word - 1;
+    }
+    return hash;
+}
+
+inline uint64_t hashBoard(const BitBoard& board) {
+    uint64_t hash = 0;
+    for (int y = 0; y < board.getHeight(); y++)
+        for (int i = 0; i < board.getWordsPerRow(); i++)
+            hash ^= hashWord(board.row(y)[i], (uint64_t)y * board.getWidth() + i * 64);
+    return hash;
+}
+
+// The last Capacity board hashes with the generation each was first seen at.
+// Seeing a hash again means the board repeats with period
+// (generation - first generation), up to 64-bit hash collisions.
+class HashHistory {
+private:
+    struct Entry {
+        uint64_t Hash;
+        long long Generation;
+    };
+
+    std::vector<Entry> Ring;
+    std::unordered_map<uint64_t, long long> Index;
+    size_t Capacity, Next;
+
+public:
+    explicit HashHistory(size_t capacity = 4096) : Capacity(capacity), Next(0) {}
+
+    size_t getCapacity() const { return Capacity; }
+
+    // Approximate: the index is counted as one node plus one bucket per entry.
+    size_t getMemoryUsage() const {
+        return Ring.capacity() * sizeof(Entry) + Index.size() * (sizeof(std::pair<const uint64_t, long long>) + 2 * sizeof(void*));
+    }
+
+    void clear() {
+        Ring.clear();
+        Index.clear();
+        Next = 0;
+    }
+
+    // Returns the generation the hash was recorded at before, or -1 after recording it.
+    long long record(uint64_t hash, long long generation) {
+        auto found = Index.find(hash);
+        if (found != Index.end())
+            return found->second;
+        Entry entry = { hash, generation };
+        if (Ring.size() < Capacity)
+            Ring.push_back(entry);
+        else {
+            Entry& oldest = Ring[Next];
+            auto indexed = Index.find(oldest.Hash);
+            if (indexed != Index.end() and indexed->second == oldest.Generation)
+                Index.erase(indexed);
+            oldest = entry;
+        }
+        Next = (Next + 1) % Capacity;
+        Index[hash] = generation;
+        return -1;
+    }
+};
@@ -0,0 +1,328 @@
+#include "Checkpoint.h"
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <vector>
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char MAGIC[8] = { 'G', 'O', 'L', 'C', 'K', 'P', 'T', '1' };
+static constexpr uint32_t VERSION = 2;
+static constexpr uint32_t FLAG_TILES = 1;
+static constexpr uint32_t FLAG_STATES = 2;
+static constexpr size_t HEADERSIZE = 64;
+static constexpr size_t RULESIZE = 24;     // version 1: the rule in the header, zero padded
+static constexpr size_t MAXRULESIZE = 4096; // version 2: length in the header, the rule after it
+static constexpr int TILEROWS = 64;
+static constexpr int MAXSIDE = 1 << 20;
+
+// Read-only view of a whole file: mapped when the system allows it, read into
+// memory otherwise.
+class MappedFile {
+private:
+    const uint8_t* Data;
+    size_t Size;
+    std::vector<uint8_t> Copy;
+#if defined(_WIN32)
+    HANDLE File, Mapping;
+#else
+    int Descriptor;
+#endif
+
+public:
+    explicit MappedFile(const std::string& path) : Data(nullptr), Size(0) {
+#if defined(_WIN32)
+        Mapping = nullptr;
+        File = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        LARGE_INTEGER fileSize;
+        if (File != INVALID_HANDLE_VALUE and GetFileSizeEx(File, &fileSize) and fileSize.QuadPart > 0) {
+            Mapping = CreateFileMappingA(File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (Mapping)
+                Data = (const uint8_t*)MapViewOfFile(Mapping, FILE_MAP_READ, 0, 0, 0);
+            Size = Data ? (size_t)fileSize.QuadPart : 0;
+        }
+#else
+        Descriptor = open(path.c_str(), O_RDONLY);
+        struct stat status;
+        if (Descriptor >= 0 and fstat(Descriptor, &status) == 0 and status.st_size > 0) {
+            void* mapping = mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, Descriptor, 0);
+            if (mapping != MAP_FAILED) {
+                Data = (const uint8_t*)mapping;
+                Size = (size_t)status.st_size;
+                madvise(mapping, Size, MADV_SEQUENTIAL);
+            }
+        }
+#endif
+        if (!Data) {
+            std::ifstream file(path, std::ios::binary);
+            Copy.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            Data = Copy.empty() ? nullptr : Copy.data();
+            Size = Copy.size();
+        }
+    }
+
+    ~MappedFile() {
+#if defined(_WIN32)
+        if (Data and Copy.empty())
+            UnmapViewOfFile(Data);
+        if (Mapping)
+            CloseHandle(Mapping);
+        if (File != INVALID_HANDLE_VALUE)
+            CloseHandle(File);
+#else
+        if (Data and Copy.empty())
+            munmap((void*)Data, Size);
+        if (Descriptor >= 0)
+            close(Descriptor);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const uint8_t* getData() const { return Data; }
+
+    size_t getSize() const { return Size; }
+};
+
+template <typename T>
+static void putField(uint8_t* header, size_t offset, T value) {
+    std::memcpy(header + offset, &value, sizeof(T));
+}
+
+template <typename T>
+static T getField(const uint8_t* header, size_t offset) {
+    T value;
+    std::memcpy(&value, header + offset, sizeof(T));
+    return value;
+}
+
+static bool isTileEmpty(const BitBoard& board, int tx, int ty) {
+    int yEnd = std::min(board.getHeight(), (ty + 1) * TILEROWS);
+    for (int y = ty * TILEROWS; y < yEnd; y++)
+        if (board.row(y)[tx] != 0)
+            return false;
+    return true;
+}
+
+bool writeCheckpoint(const std::string& path, const BitBoard& board, const CheckpointInfo& info, bool compress) {
+    uint8_t header[HEADERSIZE] = {};
+    std::memcpy(header, MAGIC, sizeof(MAGIC));
+    putField<uint32_t>(header, 8, VERSION);
+    if (!info.States.empty() and info.States.size() != (size_t)board.getWidth() * board.getHeight())
+        return false;
+    putField<uint32_t>(header, 12, (compress ? FLAG_TILES : 0) | (info.States.empty() ? 0 : FLAG_STATES));
+    putField<int32_t>(header, 16, board.getWidth());
+    putField<int32_t>(header, 20, board.getHeight());
+    putField<int64_t>(header, 24, info.Generation);
+    putField<int64_t>(header, 32, info.Population);
+    if (info.Rule.size() > MAXRULESIZE)
+        return false;
+    putField<uint32_t>(header, 40, (uint32_t)info.Rule.size());
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+    file.write((const char*)header, HEADERSIZE);
+    file.write(info.Rule.data(), info.Rule.size());
+    int wordsPerRow = board.getWordsPerRow();
+    if (!compress) {
+        for (int y = 0; y < board.getHeight(); y++)
+            file.write((const char*)board.row(y), wordsPerRow * sizeof(uint64_t));
+        file.write((const char*)info.States.data(), info.States.size());
+        file.close();
+        return !file.fail();
+    }
+    int tilesY = (board.getHeight() + TILEROWS - 1) / TILEROWS;
+    std::vector<uint8_t> bitmap(((size_t)wordsPerRow * tilesY + 63) / 64 * 8, 0);
+    for (int ty = 0; ty < tilesY; ty++)
+        for (int tx = 0; tx < wordsPerRow; tx++)
+            if (!isTileEmpty(board, tx, ty)) {
+                size_t tile = (size_t)ty * wordsPerRow + tx;
+                bitmap[tile >> 3] |= (uint8_t)(1 << (tile & 7));
+            }
+    file.write((const char*)bitmap.data(), bitmap.size());
+    std::vector<uint64_t> words;
+    for (int ty = 0; ty < tilesY; ty++) {
+        for (int tx = 0; tx < wordsPerRow; tx++) {
+            size_t tile = (size_t)ty * wordsPerRow + tx;
+            if (!(bitmap[tile >> 3] >> (tile & 7) & 1))
+                continue;
+            words.clear();
+            for (int y = ty * TILEROWS; y < std::min(board.getHeight(), (ty + 1) * TILEROWS); y++)
+                words.push_back(board.row(y)[tx]);
+            file.write((const char*)words.data(), words.size() * sizeof(uint64_t));
+        }
+    }
+    file.write((const char*)info.States.data(), info.States.size());
+    // Closing flushes the buffer; a full disk only shows up here.
+    file.close();
+    return !file.fail();
+}
+
+bool readCheckpoint(const std::string& path, BitBoard& board, CheckpointInfo& info) {
+    MappedFile file(path);
+    const uint8_t* data = file.getData();
+    if (!data or file.getSize() < HEADERSIZE or std::memcmp(data, MAGIC, sizeof(MAGIC)) != 0)
+        return false;
+    uint32_t flags = getField<uint32_t>(data, 12);
+    int width = getField<int32_t>(data, 16);
+    int height = getField<int32_t>(data, 20);
+    uint32_t version = getField<uint32_t>(data, 8);
+    if ((version != 1 and version != VERSION) or width < 1 or height < 1 or width > MAXSIDE or height > MAXSIDE)
+        return false;
+    info.Generation = getField<int64_t>(data, 24);
+    info.Population = getField<int64_t>(data, 32);
+    size_t ruleSize = 0;
+    if (version == 1)
+        info.Rule.assign((const char*)data + 40, strnlen((const char*)data + 40, RULESIZE));
+    else {
+        ruleSize = getField<uint32_t>(data, 40);
+        if (ruleSize > MAXRULESIZE or file.getSize() - HEADERSIZE < ruleSize)
+            return false;
+        info.Rule.assign((const char*)data + HEADERSIZE, ruleSize);
+    }
+
+    BitBoard loaded(height, width);
+    int wordsPerRow = loaded.getWordsPerRow();
+    const uint8_t* payload = data + HEADERSIZE + ruleSize;
+    size_t payloadSize = file.getSize() - HEADERSIZE - ruleSize;
+    size_t offset;
+    if (!(flags & FLAG_TILES)) {
+        size_t rowBytes = wordsPerRow * sizeof(uint64_t);
+        if (payloadSize < rowBytes * height)
+            return false;
+        for (int y = 0; y < height; y++)
+            std::memcpy(loaded.row(y), payload + rowBytes * y, rowBytes);
+        offset = rowBytes * height;
+    }
+    else {
+        int tilesY = (height + TILEROWS - 1) / TILEROWS;
+        size_t bitmapSize = ((size_t)wordsPerRow * tilesY + 63) / 64 * 8;
+        if (payloadSize < bitmapSize)
+            return false;
+        const uint8_t* bitmap = payload;
+        offset = bitmapSize;
+        for (int ty = 0; ty < tilesY; ty++) {
+            for (int tx = 0; tx < wordsPerRow; tx++) {
+                size_t tile = (size_t)ty * wordsPerRow + tx;
+                if (!(bitmap[tile >> 3] >> (tile & 7) & 1))
+                    continue;
+                int yEnd = std::min(height, (ty + 1) * TILEROWS);
+                if (payloadSize < offset + (size_t)(yEnd - ty * TILEROWS) * sizeof(uint64_t))
+                    return false;
+                for (int y = ty * TILEROWS; y < yEnd; y++, offset += sizeof(uint64_t))
+                    std::memcpy(&loaded.row(y)[tx], payload + offset, sizeof(uint64_t));
+            }
+        }
+    }
+    // Padding bits must stay zero, whatever the file says.
+    for (int y = 0; y < height; y++)
+        loaded.row(y)[wordsPerRow - 1] &= loaded.getLastWordMask();
+    info.States.clear();
+    if (flags & FLAG_STATES) {
+        size_t cells = (size_t)width * height;
+        if (payloadSize - offset < cells)
+            return false;
+        info.States.assign(payload + offset, payload + offset + cells);
+    }
+    board.swap(loaded);
+    return true;
+}
+
+// Waits until the file is on the disk, not just in the page cache, so a power
+// loss after the rename cannot leave the new name on a partly written file.
+static bool syncFile(const std::string& path) {
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    bool synced = FlushFileBuffers(file) != 0;
+    CloseHandle(file);
+    return synced;
+#else
+    int descriptor = open(path.c_str(), O_RDONLY);
+    if (descriptor < 0)
+        return false;
+    bool synced = fsync(descriptor) == 0;
+    close(descriptor);
+    return synced;
+#endif
+}
+
+bool isCheckpointFile(const std::string& path) {
+    char magic[sizeof(MAGIC)];
+    std::ifstream file(path, std::ios::binary);
+    return file.read(magic, sizeof(magic)) and std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+CheckpointWriter::CheckpointWriter() : Compress(true), Pending(false), Busy(false), Stopping(false), LastResult(true) {
+    Worker = std::thread(&CheckpointWriter::workerLoop, this);
+}
+
+CheckpointWriter::~CheckpointWriter() {
+    {
+        std::lock_guard<std::mutex> lock(Mutex);
+        Stopping = true;
+    }
+    WakeUp.notify_all();
+    Worker.join();
+}
+
+bool CheckpointWriter::save(const std::string& path, const BitBoard& board, const CheckpointInfo& info, bool compress) {
+    std::lock_guard<std::mutex> lock(Mutex);
+    if (Pending or Busy)
+        return false;
+    Board = board;
+    Info = info;
+    Path = path;
+    Compress = compress;
+    Pending = true;
+    WakeUp.notify_all();
+    return true;
+}
+
+bool CheckpointWriter::wait() {
+    std::unique_lock<std::mutex> lock(Mutex);
+    Idle.wait(lock, [this] { return !Pending and !Busy; });
+    return LastResult;
+}
+
+void CheckpointWriter::workerLoop() {
+    std::unique_lock<std::mutex> lock(Mutex);
+    while (true) {
+        // A pending checkpoint is still written when stopping.
+        WakeUp.wait(lock, [this] { return Pending or Stopping; });
+        if (!Pending)
+            return;
+        Pending = false;
+        Busy = true;
+        lock.unlock();
+
+        std::string temporary = Path + ".tmp";
+        bool written = writeCheckpoint(temporary, Board, Info, Compress) and syncFile(temporary);
+        if (!written)
+            std::remove(temporary.c_str()); // the last good checkpoint stays
+        else {
+#if defined(_WIN32)
+            written = MoveFileExA(temporary.c_str(), Path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+            written = std::rename(temporary.c_str(), Path.c_str()) == 0; // replaces the old file atomically
+#endif
+        }
+
+        lock.lock();
+        LastResult = written;
+        Busy = false;
+        Idle.notify_all();
+    }
+}
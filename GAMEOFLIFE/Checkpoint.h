@@ -0,0 +1,69 @@
+#pragma once
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "BitBoard.h"
+
+// Binary snapshot of a run, for resuming it in another process.
+//
+// A 64-byte header (magic "GOLCKPT1", version, flags, width, height,
+// generation, population, length of the rule name) is followed by the rule
+// name and the board. Version 1 files, which kept the rule in the header cut
+// to 23 bytes, are still read. Uncompressed, the payload is the board words
+// row after row, exactly as BitBoard stores them.
+// Tile-compressed, it is a bitmap of the non-empty tiles (64 rows by one word,
+// as in GameOfLife) followed by the words of those tiles only. Rules with
+// dying states add a byte per cell, row after row, after the board. All
+// numbers are little-endian.
+struct CheckpointInfo {
+    long long Generation;
+    long long Population;
+    std::string Rule;
+    std::vector<uint8_t> States; // GameOfLife::getCellStates(), empty for two states
+};
+
+bool writeCheckpoint(const std::string& path, const BitBoard& board, const CheckpointInfo& info, bool compress = true);
+
+// The file is memory-mapped, so the only work on load is copying the words
+// into the board.
+bool readCheckpoint(const std::string& path, BitBoard& board, CheckpointInfo& info);
+
+// True if the file starts with the checkpoint magic.
+bool isCheckpointFile(const std::string& path);
+
+// Writes checkpoints on its own thread. save() only copies the board, so the
+// stepping loop is not held up by compression or disk writes. The file is
+// written next to the target and renamed over it once complete and on the
+// disk, so a crash never leaves a truncated checkpoint behind. A failed write
+// keeps the old checkpoint.
+class CheckpointWriter {
+private:
+    std::thread Worker;
+    std::mutex Mutex;
+    std::condition_variable WakeUp;
+    std::condition_variable Idle;
+    BitBoard Board;
+    CheckpointInfo Info;
+    std::string Path;
+    bool Compress;
+    bool Pending, Busy, Stopping;
+    bool LastResult;
+
+    void workerLoop();
+
+public:
+    CheckpointWriter();
+    ~CheckpointWriter();
+
+    CheckpointWriter(const CheckpointWriter&) = delete;
+    CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+    // Returns false without copying anything while the previous checkpoint
+    // is still being written.
+    bool save(const std::string& path, const BitBoard& board, const CheckpointInfo& info, bool compress = true);
+
+    // Blocks until the last requested checkpoint is on disk and returns whether it was written.
+    bool wait();
+};
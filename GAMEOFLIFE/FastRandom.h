@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include "BitBoard.h"
+
+// xoshiro256** seeded through splitmix64: a few instructions per 64 random
+// bits, and the same sequence for the same seed on every platform, so a soup
+// is reproduced from its seed alone.
+class FastRandom {
+private:
+    uint64_t State[4];
+
+    static uint64_t rotate(uint64_t word, int bits) { return (word << bits) | (word >> (64 - bits)); }
+
+public:
+    explicit FastRandom(uint64_t seed = 0) { reseed(seed); }
+
+    void reseed(uint64_t seed) {
+        for (uint64_t& word : State) {
+            uint64_t z = (seed += 0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            word = z ^ (z >> 31);
+        }
+    }
+
+    uint64_t next() {
+        uint64_t result = rotate(State[1] * 5, 7) * 9;
+        uint64_t shifted = State[1] << 17;
+        State[2] ^= State[0];
+        State[3] ^= State[1];
+        State[1] ^= State[2];
+        State[0] ^= State[3];
+        State[2] ^= shifted;
+        State[3] = rotate(State[3], 45);
+        return result;
+    }
+};
+
+// Every cell alive with probability 1/2, one random word per 64 cells.
+inline void fillRandom(BitBoard& board, FastRandom& random) {
+    int words = board.getWordsPerRow();
+    for (int y = 0; y < board.getHeight(); y++) {
+        uint64_t* row = board.row(y);
+        for (int i = 0; i < words; i++)
+            row[i] = random.next();
+        if (words > 0)
+            row[words - 1] &= board.getLastWordMask();
+    }
+}
@@ -0,0 +1,56 @@
+#include "FrameScheduler.h"
+#include <algorithm>
+
+constexpr double FrameScheduler::MAXLAG;
+
+FrameScheduler::FrameScheduler(double generationInterval, double frameRate) {
+    setGenerationInterval(generationInterval);
+    setFrameRate(frameRate);
+    restart();
+}
+
+void FrameScheduler::setGenerationInterval(double seconds) {
+    GenerationInterval = toDuration(std::max(0.0, seconds));
+}
+
+void FrameScheduler::setFrameRate(double framesPerSecond) {
+    FrameInterval = toDuration(1.0 / std::max(1.0, framesPerSecond));
+}
+
+void FrameScheduler::restart() {
+    NextFrame = Clock::now();
+    NextGeneration = NextFrame + GenerationInterval;
+}
+
+// As fast as possible, generations run until the next frame is due.
+bool FrameScheduler::isGenerationDue() const {
+    Clock::time_point now = Clock::now();
+    return isAsFastAsPossible() ? now < NextFrame : now >= NextGeneration;
+}
+
+void FrameScheduler::generationDone() {
+    Clock::time_point now = Clock::now();
+    NextGeneration += GenerationInterval;
+    if (now - NextGeneration > toDuration(MAXLAG))
+        NextGeneration = now;
+}
+
+void FrameScheduler::frameDone() {
+    Clock::time_point now = Clock::now();
+    NextFrame += FrameInterval;
+    if (NextFrame < now)
+        NextFrame = now + FrameInterval;
+}
+
+int FrameScheduler::getWaitMillis(bool running, bool frameWanted) const {
+    if (running and isAsFastAsPossible())
+        return 0;
+    if (!running and !frameWanted)
+        return -1;
+    Clock::time_point wake = running ? NextGeneration : NextFrame;
+    if (running and frameWanted)
+        wake = std::min(wake, NextFrame);
+    // Rounded up, so the wait does not end just before the deadline and spin.
+    long long micros = std::chrono::duration_cast<std::chrono::microseconds>(wake - Clock::now()).count();
+    return (int)std::max(0LL, (micros + 999) / 1000);
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <chrono>
+
+// Paces the simulation and the screen on steady_clock, separately: generations
+// are due every GenerationInterval seconds and frames at most FrameRate times a
+// second. With a zero interval generations run as fast as possible and fill
+// the time between frames, so a slow frame delays drawing, never the
+// simulation. getWaitMillis() tells how long the input wait may block.
+class FrameScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+private:
+    // A fixed rate that falls further behind than this gives up catching up.
+    static constexpr double MAXLAG = 1.0;
+
+    Clock::duration GenerationInterval;
+    Clock::duration FrameInterval;
+    Clock::time_point NextGeneration;
+    Clock::time_point NextFrame;
+
+    static Clock::duration toDuration(double seconds) {
+        return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+    }
+
+public:
+    FrameScheduler(double generationInterval, double frameRate);
+
+    // 0 - as fast as possible.
+    void setGenerationInterval(double seconds);
+
+    void setFrameRate(double framesPerSecond);
+
+    bool isAsFastAsPossible() const { return GenerationInterval == Clock::duration::zero(); }
+
+    // Makes a frame due now and the next generation one interval later.
+    void restart();
+
+    bool isGenerationDue() const;
+
+    Clock::time_point getNextGeneration() const { return NextGeneration; }
+
+    void generationDone();
+
+    bool isFrameDue() const { return Clock::now() >= NextFrame; }
+
+    void frameDone();
+
+    // Milliseconds until the next generation or frame, -1 to block until a key
+    // when nothing is running and nothing is left to draw.
+    int getWaitMillis(bool running, bool frameWanted) const;
+};
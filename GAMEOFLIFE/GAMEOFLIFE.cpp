@@ -1,12 +1,41 @@
 ﻿#include <curses.h>
 #include <vector>
+#include <string>
 #include <random>
+#include <memory>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <ctime>
+#include "GameOfLife.h"
+#include "PatternIO.h"
+#include "Checkpoint.h"
+#include "Headless.h"
+#include "TerminalRenderer.h"
+#include "FrameScheduler.h"
+#include "Instrumentation.h"
+#include "FastRandom.h"
+#include "SimulationThread.h"
+
+#ifndef _MSC_VER
+#define sscanf_s sscanf //форматы без строк, аргументы совпадают
+#endif
 
 int ROWS, COLS;
 bool ISLIGHTMODE = false;
-double ITERATIONTIME = 0.5;
+double ITERATIONTIME = 0.5; //0 - так быстро, как возможно
+double FRAMERATE = 30; //кадров в секунду, не больше
 int TABLEWIDTH = 100;
 int TABLEHEIGHT = 23;
+bool KERNELCROSSCHECK = false;
+int THREADCOUNT = 1;
+int HASHLIFESTEP = -1; //-1 - обычный режим, k - шаг в 2^k поколений
+bool UNBOUNDED = false; //бесконечное поле вместо тора
+int PROCESSCOUNT = 1; //больше 1 - поле делится на полосы между процессами
+int HISTORYMEGABYTES = 64; //память под историю поколений, 0 - без перемотки
+const char* CHECKPOINTFILE = "GAMEOFLIFE.ckpt"; //сохраняется при выходе из игры
+const int OPTIONMENUSIZE = 12; //пунктов в меню опций, должны помещаться в консоль наименьшего размера
+const int RECORDMINSIDE = 256, RECORDMAXSIDE = 1024; //размер записи в пикселях: мелкое поле увеличивается, крупное уменьшается
 
 static constexpr int KEY_ARROW_UP = KEY_UP;
 static constexpr int KEY_ARROW_DOWN = KEY_DOWN;
@@ -22,98 +51,271 @@ static constexpr int KEY_Y_UPPER = 89;
 static constexpr int KEY_Y_LOWER = 121;
 static constexpr int KEY_N_UPPER = 78;
 static constexpr int KEY_N_LOWER = 110;
+static constexpr int KEY_L_UPPER = 76; //загрузить шаблон
+static constexpr int KEY_L_LOWER = 108;
+static constexpr int KEY_S_UPPER = 83; //сохранить шаблон
+static constexpr int KEY_S_LOWER = 115;
+static constexpr int KEY_PLUS = 43; //приблизить
+static constexpr int KEY_MINUS = 45; //отдалить
+static constexpr int KEY_I_UPPER = 73; //показатели производительности
+static constexpr int KEY_I_LOWER = 105;
+static constexpr int KEY_BRACKET_LEFT = 91; //на поколение назад
+static constexpr int KEY_BRACKET_RIGHT = 93; //на поколение вперёд
+static constexpr int KEY_BRACE_LEFT = 123; //на 100 поколений назад
+static constexpr int KEY_BRACE_RIGHT = 125; //на 100 поколений вперёд
+static constexpr int KEY_G_UPPER = 71; //перейти к поколению
+static constexpr int KEY_G_LOWER = 103;
+static constexpr int KEY_SPACE = 32; //пауза
+static constexpr int KEY_R_UPPER = 82; //запись анимации
+static constexpr int KEY_R_LOWER = 114;
+
+// Input is polled (timeout(0)) by default; waiting for a key blocks for up to
+// millis milliseconds, or until a key with -1, instead of spinning a core.
+static int waitKey(int millis) {
+    timeout(millis);
+    int key = getch();
+    timeout(0);
+    return key;
+}
 
 static void reverseColor() {
     ISLIGHTMODE ? attroff(A_REVERSE) : attron(A_REVERSE);
     ISLIGHTMODE = !ISLIGHTMODE;
 }
 
-class GameOfLife {
-protected:
-    int Width, Height, Generation, Population;
-    std::vector<std::vector<bool>> CurrGameTable;
-    std::vector<std::vector<bool>> PrevGameTable;
+class Game : public GameOfLife {
+private:
+    // The edits below are posted to the simulation thread and applied there
+    // between two generations.
+    void randomFill() {
+        Engine.post([this] {
+            fillRandom(PrevGameTable, Random);
+            markEdited();
+        });
+    }
 
-    bool getNormalizedValue(const int& x, const int& y) {
-        return PrevGameTable[(y + Height) % Height][(x + Width) % Width];
+    void toggleCell(int x, int y) {
+        Engine.post([this, x, y] { changeCell(x, y); });
     }
 
-    void changeCell(const int& x, const int& y) {
-        if (x >= 0 && y >= 0 && x < Width && y < Height)
-            PrevGameTable[y][x] = !PrevGameTable[y][x];
+    void clearTable() {
+        Engine.post([this] { reset(); });
     }
 
-public:
-    GameOfLife(int height, int width) : Height(height), Width(width), Generation(0), Population(0), CurrGameTable(height, std::vector<bool>(width)), PrevGameTable(height, std::vector<bool>(width)) {}
-
-    int getGeneration() const { return Generation; }
-
-    int getPopulation() const { return Population; }
-
-    bool iterate() {
-        Population = 0;
-        for (int y = 0; y < Height; y++) {
-            for (int x = 0; x < Width; x++) {
-                int neighborSum = 0;
-                for (int dy = -1; dy <= 1; dy++) {
-                    for (int dx = -1; dx <= 1; dx++) {
-                        if (dx != 0 || dy != 0) {
-                            if (getNormalizedValue(x + dx, y + dy))
-                                neighborSum++;
-                        }
-                    }
-                }
-                if (!PrevGameTable[y][x] && neighborSum == 3)
-                    CurrGameTable[y][x] = true;
-                else if (PrevGameTable[y][x] && (neighborSum == 2 || neighborSum == 3))
-                    CurrGameTable[y][x] = true;
-                else
-                    CurrGameTable[y][x] = false;
-                if (CurrGameTable[y][x])
-                    Population++;
-            }
+    // Reads a line under the help text; the row is repainted by the next frame.
+    std::string askLine(const char* prompt) {
+        char path[256] = "";
+        int row = offsetY + ViewRows + 4;
+        move(row, 0);
+        clrtoeol();
+        mvprintw(row, (COLS - 40) / 2, "%s", prompt);
+        echo();
+        timeout(-1);
+        getnstr(path, sizeof(path) - 1);
+        timeout(0);
+        noecho();
+        Renderer.invalidateRows(row, 1);
+        return path;
+    }
+
+    void showFileError(const char* message) {
+        int row = offsetY + ViewRows + 4;
+        move(row, 0);
+        clrtoeol();
+        attron(COLOR_PAIR(1));
+        mvprintw(row, (COLS - 40) / 2, "%s Press ESC to continue...", message);
+        attroff(COLOR_PAIR(1));
+        while (waitKey(-1) != KEY_ESC);
+        Renderer.invalidateRows(row, 1);
+    }
+
+    // RLE, Life 1.06 or plaintext, by extension. The pattern is placed with its
+    // top-left corner at the cursor; cells outside the table are cut off.
+    // A checkpoint is placed the same way and also restores the generation.
+    // The rule of an RLE file or a checkpoint replaces the current one.
+    void loadPattern(int cursorX, int cursorY) {
+        std::string path = askLine("Pattern file: ");
+        if (path.empty())
+            return;
+        BitBoard pattern;
+        CheckpointInfo info;
+        std::string ruleName;
+        bool isCheckpoint = isCheckpointFile(path);
+        if (isCheckpoint ? !readCheckpoint(path, pattern, info) : !readPattern(path, pattern, &ruleName)) {
+            showFileError("Cannot read the pattern.");
+            return;
         }
-        Generation++;
-        bool identicalFlag = (PrevGameTable == CurrGameTable);
-        PrevGameTable = CurrGameTable;
-        return identicalFlag;
+        if (isCheckpoint)
+            ruleName = info.Rule;
+        LifeRule rule;
+        bool hasRule = !ruleName.empty();
+        if (hasRule and !parseRule(ruleName, rule)) {
+            showFileError("Unsupported rule.");
+            return;
+        }
+        long long generation = isCheckpoint ? info.Generation : 0;
+        std::vector<uint8_t> states;
+        states.swap(info.States);
+        Engine.post([this, pattern, isCheckpoint, generation, hasRule, rule, cursorX, cursorY, states] {
+            syncTable();
+            if (isCheckpoint)
+                Generation = generation;
+            if (hasRule)
+                setRule(rule);
+            int height = std::min(pattern.getHeight(), Height - cursorY);
+            int width = std::min(pattern.getWidth(), Width - cursorX);
+            for (int y = 0; y < height; y++)
+                for (int x = 0; x < width; x++)
+                    PrevGameTable.set(cursorX + x, cursorY + y, pattern.get(x, y));
+            markEdited();
+            // The dying cells of a checkpoint come back when it fills the whole board.
+            if (!states.empty() and cursorX == 0 and cursorY == 0 and pattern.getWidth() == Width and pattern.getHeight() == Height)
+                setCellStates(states);
+        });
     }
 
-    void reset() {
-        for (auto& row : PrevGameTable)
-            std::fill(row.begin(), row.end(), false);
-        Generation = 0;
-        Population = 0;
+    void savePattern() {
+        std::string path = askLine("Save to file: ");
+        if (!path.empty() and !writePattern(path, getFrame().Cells, getFrame().RuleName))
+            showFileError("Cannot write the file.");
     }
 
-    void resize(int newHeight, int newWidth) {
-        Height = newHeight;
-        Width = newWidth;
-        CurrGameTable.resize(Height, std::vector<bool>(Width));
-        PrevGameTable.resize(Height, std::vector<bool>(Width));
+    // Rewinding pauses the game. Forward keys replay the history while there
+    // is one after the shown generation and step the board past its end, or
+    // step it right away in the modes without a history.
+    void seekBy(long long delta) {
+        IsPaused = true;
+        Engine.setPaused(true);
+        Engine.post([this, delta] {
+            long long target = Generation + delta;
+            long long next = getNextRecordedGeneration();
+            if (delta < 0)
+                seekGeneration(std::max(target, getHistoryFirst()));
+            else if (next < 0 or seekGeneration(std::max(target, next)) < 0)
+                while (Generation < target and !iterate());
+        });
     }
-};
 
-class Game : public GameOfLife {
-private:
-    void randomFill() {
-        std::random_device rd;
-        std::mt19937 generator(rd());
-        std::uniform_int_distribution<int> distribution(0, 1);
-        for (int y = 0; y < Height; y++)
-            for (int x = 0; x < Width; x++)
-                PrevGameTable[y][x] = (distribution(generator) == 0);
+    // Only recorded generations can be reached; earlier ones go to the first.
+    void goToGeneration() {
+        std::string text = askLine("Go to generation: ");
+        long long generation;
+        if (sscanf_s(text.c_str(), "%lld", &generation) != 1)
+            return;
+        IsPaused = true;
+        Engine.setPaused(true);
+        Engine.post([this, generation] { seekGeneration(std::max(generation, getHistoryFirst())); });
+    }
+
+    // The first R asks for a file (.gif, .png or a raw stream, see
+    // AnimationExport.h) and records every generation from then on, the
+    // second stops. Only the simulation thread pushes frames, so both the start
+    // and the end of a recording are posted to it; the encoding runs on the
+    // writer's own thread.
+    void toggleRecording() {
+        if (Recording.isOpen()) {
+            Engine.post([this] {
+                setRecorder(nullptr, 1);
+                Recording.finish();
+            });
+            return;
+        }
+        std::string path = askLine("Record to file: ");
+        if (path.empty())
+            return;
+        int cellsPerPixel, pixelsPerCell;
+        chooseAnimationScale(Width, Height, RECORDMINSIDE, RECORDMAXSIDE, cellsPerPixel, pixelsPerCell);
+        if (!Recording.open(path, Width, Height, cellsPerPixel, pixelsPerCell, std::max(20, (int)(ITERATIONTIME * 1000)))) {
+            showFileError("Cannot write the file.");
+            return;
+        }
+        Engine.post([this] { setRecorder(&Recording, 1); });
+    }
+
+    // Key handling shared by the editor and the running game; false for other keys.
+    bool handleHistoryKey(int key) {
+        switch (key) {
+        case KEY_BRACKET_LEFT:
+            seekBy(-1);
+            return true;
+        case KEY_BRACKET_RIGHT:
+            seekBy(1);
+            return true;
+        case KEY_BRACE_LEFT:
+            seekBy(-100);
+            return true;
+        case KEY_BRACE_RIGHT:
+            seekBy(100);
+            return true;
+        case KEY_G_UPPER:
+        case KEY_G_LOWER:
+            goToGeneration();
+            return true;
+        }
+        return false;
+    }
+
+    // Above the board, inside the frame, so that shorter text leaves nothing behind.
+    void drawHistory(bool isRunning) {
+        const LifeFrame& frame = getFrame();
+        char text[160];
+        int length;
+        if (frame.HistoryFirst < 0)
+            length = snprintf(text, sizeof(text), "History: off");
+        else
+            length = snprintf(text, sizeof(text), "History: %lld-%lld, %.1f MB | Back/forward - [ ] { } | Go to - G",
+                              frame.HistoryFirst, frame.HistoryLast, frame.HistoryBytes / 1048576.0);
+        if (isRunning)
+            length += snprintf(text + length, sizeof(text) - length, IsPaused ? " | Resume - SPACE" : " | Pause - SPACE");
+        if (isRunning and Recording.isOpen())
+            length += snprintf(text + length, sizeof(text) - length, " | Stop recording - R (%lld frames)", Recording.getFramesWritten());
+        else if (isRunning)
+            length += snprintf(text + length, sizeof(text) - length, " | Record - R");
+        chtype normal = ISLIGHTMODE ? A_REVERSE : A_NORMAL;
+        Renderer.putText(offsetY - 5, std::max(0, (COLS - length) / 2), text, normal);
+    }
+
+    // The objects the board settled into, cut to the width of the terminal.
+    void drawCensus() {
+        const LifeFrame& frame = getFrame();
+        std::string text = "Stable condition has been achieved!";
+        if (!frame.Census.empty())
+            text = "Stable condition has been achieved: " + frame.Census;
+        if ((int)text.size() > COLS)
+            text = text.substr(0, std::max(0, COLS - 3)) + "...";
+        chtype normal = ISLIGHTMODE ? A_REVERSE : A_NORMAL;
+        Renderer.putText(offsetY - 3, std::max(0, (COLS - (int)text.size()) / 2), text.c_str(), normal);
     }
 
     bool editTable() {
-        int cursorX = 0;
-        int cursorY = 0;
+        int cursorX = ViewX;
+        int cursorY = ViewY;
+        if (Zoom >= 3)
+            Engine.setPyramidWanted(false);
+        Zoom = 0;
+        layout();
         while (true) {
+            // Keys wait in the curses queue until the last edit shows in a frame.
+            Engine.update();
+            if (!Engine.isCurrent()) {
+                napms(1);
+                continue;
+            }
+            followCursor(cursorX, cursorY);
             display(cursorX, cursorY);
-            mvprintw(offsetY + Height + 1, (COLS - 74) / 2, "Change the state - END | Random fill - HOME | Clear - DEL | Start - ENTER");
-            mvprintw(offsetY + Height + 2, (COLS - 41) / 2, "UP/DOWN/RIGHT/LEFT - Arrows | Exit - ESC");
-            int key = getch();
+            mvprintw(offsetY + ViewRows + 1, (COLS - 74) / 2, "Change the state - END | Random fill - HOME | Clear - DEL | Start - ENTER");
+            mvprintw(offsetY + ViewRows + 2, (COLS - 41) / 2, "UP/DOWN/RIGHT/LEFT - Arrows | Exit - ESC");
+            mvprintw(offsetY + ViewRows + 3, (COLS - 52) / 2, "Load pattern at the cursor - L | Save pattern - S");
+            int key = waitKey(-1);
             switch (key) {
+            case KEY_L_UPPER:
+            case KEY_L_LOWER:
+                loadPattern(cursorX, cursorY);
+                break;
+            case KEY_S_UPPER:
+            case KEY_S_LOWER:
+                savePattern();
+                break;
             case KEY_CONFIRM:
                 return true;
                 break;
@@ -121,13 +323,13 @@ private:
                 return false;
                 break;
             case KEY_CHANGE_CELL:
-                changeCell(cursorX, cursorY);
+                toggleCell(cursorX, cursorY);
                 break;
             case KEY_RANDOM_FILL:
                 randomFill();
                 break;
             case KEY_CLEAR_SCREEN:
-                reset();
+                clearTable();
                 break;
             case KEY_ARROW_UP:
                 cursorY = (cursorY - 1 + Height) % Height;
@@ -141,76 +343,335 @@ private:
             case KEY_ARROW_RIGHT:
                 cursorX = (cursorX + 1) % Width;
                 break;
+            default:
+                handleHistoryKey(key);
+                break;
             }
         }
     }
 
     int offsetX, offsetY;
+    TerminalRenderer Renderer;
+    CheckpointWriter Checkpoints;
+    AnimationWriter Recording;
+    FrameScheduler Scheduler;
+    FastRandom Random; //инициализируется один раз
+
+    // The simulation runs on its own thread while the game is on screen; the
+    // screen is drawn from its latest frame, never from the tables themselves.
+    SimulationThread Engine;
+
+    // Set by SPACE and by rewinding; the simulation thread is paused along with it.
+    bool IsPaused;
+
+    const LifeFrame& getFrame() const { return Engine.getFrame(); }
+
+    // Measured only while the overlay is shown: Stats on this thread (render
+    // and input), SimulationStats on the simulation thread, read from the frames.
+    Instrumentation Stats;
+    Instrumentation SimulationStats;
+    bool ShowStats;
+
+    Instrumentation* getStats() { return ShowStats ? &Stats : nullptr; }
+
+    void toggleStats() {
+        ShowStats = !ShowStats;
+        Stats.restart();
+        bool enabled = ShowStats;
+        Engine.post([this, enabled] {
+            SimulationStats.restart();
+            setInstrumentation(enabled ? &SimulationStats : nullptr);
+        });
+    }
+
+    // Phase times, rates, allocations and the recent population as a sparkline,
+    // drawn over the top-left corner of the board.
+    void drawStats() {
+        if (!getFrame().HasStats)
+            return;
+        const Instrumentation& simulation = getFrame().Stats;
+        static const char levels[] = " .:-=+*#%@";
+        static const Phase phases[PHASECOUNT] = { Phase::Step, Phase::StableCheck, Phase::Render, Phase::Input };
+        static const char* const names[PHASECOUNT] = { "Step", "Stable check", "Render", "Input" };
+        static constexpr int SPARKLINE = 30;
+        chtype attributes = ISLIGHTMODE ? A_NORMAL : A_REVERSE;
+        int top = offsetY - 1, left = offsetX + 1;
+        char line[64];
+        for (int i = 0; i < PHASECOUNT; i++) {
+            const Instrumentation& source = phases[i] == Phase::Render or phases[i] == Phase::Input ? Stats : simulation;
+            std::snprintf(line, sizeof(line), " %-12s %9.1f us  avg %9.1f us ", names[i], source.getLastMicros(phases[i]), source.getAverageMicros(phases[i]));
+            Renderer.putText(top + i, left, line, attributes);
+        }
+        long long generations = simulation.getGenerations();
+        std::snprintf(line, sizeof(line), " Generations/s  %-27.1f ", simulation.getGenerationRate());
+        Renderer.putText(top + 4, left, line, attributes);
+        std::snprintf(line, sizeof(line), " Cell updates/s %-27.3g ", simulation.getCellRate());
+        Renderer.putText(top + 5, left, line, attributes);
+        if (simulation.getAllocations() < 0)
+            std::snprintf(line, sizeof(line), " Allocations    %-27s ", "not counted");
+        else
+            std::snprintf(line, sizeof(line), " Allocations    %-10lld %6.2f per gen   ", simulation.getAllocations(),
+                          generations > 0 ? (double)simulation.getAllocations() / generations : 0.0);
+        Renderer.putText(top + 6, left, line, attributes);
+
+        std::vector<long long> series = simulation.getPopulationSeries(SPARKLINE);
+        long long low = series.empty() ? 0 : *std::min_element(series.begin(), series.end());
+        long long high = series.empty() ? 0 : *std::max_element(series.begin(), series.end());
+        char sparkline[SPARKLINE + 1];
+        for (int i = 0; i < SPARKLINE; i++) {
+            int index = i - (SPARKLINE - (int)series.size());
+            if (index < 0)
+                sparkline[i] = ' ';
+            else
+                sparkline[i] = levels[high == low ? 5 : 1 + (int)((series[index] - low) * 8 / (high - low))];
+        }
+        sparkline[SPARKLINE] = '\0';
+        std::snprintf(line, sizeof(line), " Population [%s]", sparkline);
+        Renderer.putText(top + 7, left, line, attributes);
+        std::snprintf(line, sizeof(line), "             %-15lld%15lld ", low, high);
+        Renderer.putText(top + 8, left, line, attributes);
+    }
+
+    // Viewport: the board cell at the top-left corner, the zoom level (every
+    // character shows 2^Zoom x 2^Zoom cells) and the size on screen in characters.
+    int ViewX, ViewY, Zoom;
+    int ViewCols, ViewRows;
+
+    // Ten rows are kept free for the status lines above and below the board.
+    void layout() {
+        ViewCols = std::max(1, std::min(((Width - 1) >> Zoom) + 1, COLS - 2));
+        ViewRows = std::max(1, std::min(((Height - 1) >> Zoom) + 1, ROWS - 10));
+        offsetX = (COLS - ViewCols) / 2;
+        offsetY = (ROWS - ViewRows) / 2;
+        clampView();
+        drawBorder();
+        Renderer.invalidate();
+    }
+
+    // Keeps the viewport inside the board, aligned to whole blocks of the zoom level.
+    void clampView() {
+        ViewX = std::max(0, std::min(ViewX, Width - (ViewCols << Zoom))) >> Zoom << Zoom;
+        ViewY = std::max(0, std::min(ViewY, Height - (ViewRows << Zoom))) >> Zoom << Zoom;
+    }
+
+    void followCursor(int cursorX, int cursorY) {
+        ViewX = std::min(ViewX, cursorX);
+        ViewX = std::max(ViewX, cursorX - ViewCols + 1);
+        ViewY = std::min(ViewY, cursorY);
+        ViewY = std::max(ViewY, cursorY - ViewRows + 1);
+    }
+
+    void pan(int dx, int dy) {
+        ViewX += dx * std::max(1, ViewCols / 4) << Zoom;
+        ViewY += dy * std::max(1, ViewRows / 4) << Zoom;
+        clampView();
+    }
+
+    // Zooms around the centre of the view; zooming out stops once the whole board fits.
+    void zoom(int step) {
+        int newZoom = Zoom + step;
+        if (newZoom < 0 or (step > 0 and ViewCols >= ((Width - 1) >> Zoom) + 1 and ViewRows >= ((Height - 1) >> Zoom) + 1))
+            return;
+        int centreX = ViewX + (ViewCols << Zoom) / 2;
+        int centreY = ViewY + (ViewRows << Zoom) / 2;
+        if ((newZoom >= 3) != (Zoom >= 3))
+            Engine.setPyramidWanted(newZoom >= 3);
+        Zoom = newZoom;
+        layout();
+        ViewX = centreX - (ViewCols << Zoom) / 2;
+        ViewY = centreY - (ViewRows << Zoom) / 2;
+        clampView();
+    }
+
+    // The background and the border do not change while the game runs, so they
+    // go into the renderer's static layer once instead of being drawn every frame.
+    void drawBorder() {
+        chtype normal = ISLIGHTMODE ? A_REVERSE : A_NORMAL;
+        Renderer.resize(ROWS, COLS);
+        Renderer.clearStatic(' ' | normal);
+        for (int y = 0; y < ViewRows + 2; y++)
+            for (int x = 0; x < ViewCols + 2; x++)
+                if (x == 0 or y == 0 or x == ViewCols + 1 or y == ViewRows + 1)
+                    Renderer.putStatic(offsetY + y - 2, offsetX + x, ' ' | (normal ^ A_REVERSE));
+    }
+
+    // Live cells in the 2^Zoom x 2^Zoom block of the board at (x, y). From 8x8
+    // blocks up the count comes from the population pyramid of the frame, so a
+    // frame costs the same at every zoom level instead of rescanning the board.
+    uint32_t countBlock(int x, int y) {
+        if (Zoom >= 3)
+            return getFrame().Pyramid.getCount(Zoom - 3, x >> Zoom, y >> Zoom);
+        int side = 1 << Zoom;
+        uint32_t count = 0;
+        for (int row = y; row < std::min(Height, y + side); row++)
+            count += popcount64((getFrame().Cells.row(row)[x >> 6] >> (x & 63)) & ((1ULL << side) - 1));
+        return count;
+    }
 
 public:
-    Game(int height, int width) : GameOfLife(height, width), offsetX((COLS - Width) / 2), offsetY((ROWS - Height) / 2) {}
+    Game(int height, int width) : GameOfLife(height, width), offsetX((COLS - Width) / 2), offsetY((ROWS - Height) / 2), Scheduler(ITERATIONTIME, FRAMERATE), Random(std::random_device()()), IsPaused(false), ShowStats(false), ViewX(0), ViewY(0), Zoom(0), ViewCols(width), ViewRows(height) {
+        setHistoryBudget((size_t)HISTORYMEGABYTES << 20);
+    }
+
+    void displayStatus(time_t initialTime) {
+        const LifeFrame& frame = getFrame();
+        if (frame.IsStable and frame.Period > 1) mvprintw(offsetY - 4, (COLS - 40) / 2, "Period %lld since generation %lld", frame.Period, frame.CycleStart);
+        mvprintw(offsetY + ViewRows + 1, (COLS - 10) / 2, "Edit - INS");
+        mvprintw(offsetY + ViewRows + 2, (COLS - 10) / 2, "Exit - ESC");
+        mvprintw(offsetY + ViewRows + 1, (COLS - 10) / 2 - 25, "Generation: %-12lld", frame.Generation);
+        mvprintw(offsetY + ViewRows + 2, (COLS - 10) / 2 - 25, "Population: %-12lld", frame.Population);
+        mvprintw(offsetY + ViewRows + 1, (COLS - 10) / 2 + 20, "Time: %d %s", (time(NULL) - initialTime), "sec");
+        if (!frame.LifeLike)
+            mvprintw(offsetY + ViewRows + 2, (COLS - 10) / 2 + 20, "Kernel: cell states");
+        else if (getHashLifeStep() >= 0)
+            mvprintw(offsetY + ViewRows + 2, (COLS - 10) / 2 + 20, "Kernel: HashLife 2^%d", getHashLifeStep());
+        else if (isUnbounded())
+            mvprintw(offsetY + ViewRows + 2, (COLS - 10) / 2 + 20, "Kernel: Unbounded, %d chunks", (int)frame.ChunkCount);
+        else if (frame.ClusterProcesses > 0)
+            mvprintw(offsetY + ViewRows + 2, (COLS - 10) / 2 + 20, "Kernel: %s, %d processes", getKernelName(frame.ActiveKernel), frame.ClusterProcesses);
+        else
+            mvprintw(offsetY + ViewRows + 2, (COLS - 10) / 2 + 20, "Kernel: %s", getKernelName(frame.ActiveKernel));
+        mvprintw(offsetY + ViewRows + 3, (COLS - 10) / 2 - 25, "Frame: %lld us, %d cells", Renderer.getLastFrameMicros(), Renderer.getLastCellsEmitted());
+        mvprintw(offsetY + ViewRows + 3, (COLS - 10) / 2, "Stats - I");
+        if (CrossCheck) mvprintw(offsetY + ViewRows + 3, (COLS - 10) / 2 + 20, "Mismatches: %d", frame.KernelMismatches);
+        mvprintw(offsetY + ViewRows + 4, (COLS - 10) / 2 - 25, "Zoom: 1:%d", 1 << Zoom);
+        mvprintw(offsetY + ViewRows + 4, (COLS - 10) / 2, "Pan - Arrows | Zoom - +/-");
+        mvprintw(offsetY + ViewRows + 4, (COLS - 10) / 2 + 30, "Rule: %s", frame.RuleName.c_str());
+    }
 
+    // The simulation thread steps the board and publishes frames; this loop
+    // only draws the newest one, at most FRAMERATE times a second, and handles
+    // the keys. Once the board is stable and drawn it blocks until a key is pressed.
     void run() {
-        bool isStable = false;
+        bool isDirty = true; //есть что показать
         time_t initialTime = time(NULL);
-        time_t lastTime = time(NULL);
-        offsetX = (COLS - Width) / 2;
-        offsetY = (ROWS - Height) / 2;
+        layout();
 
-        if (!editTable())
+        Engine.start(*this, ITERATIONTIME, FRAMERATE, true);
+        Engine.update();
+        if (!editTable()) {
+            Engine.stop();
             return;
+        }
+        IsPaused = false;
+        Engine.setPaused(false);
+        Renderer.invalidate();
+        Scheduler.setFrameRate(FRAMERATE);
+        Scheduler.restart();
         while (true) {
-            switch (getch()) {
+            if (Engine.update())
+                isDirty = true;
+            if (isDirty and Scheduler.isFrameDue()) {
+                PhaseTimer renderTimer(getStats(), Phase::Render);
+                display();
+                displayStatus(initialTime);
+                Scheduler.frameDone();
+                isDirty = false;
+            }
+            bool isIdle = (getFrame().IsStable or IsPaused) and Engine.isCurrent() and !isDirty;
+            // Only handling a key counts as input, not waiting for it.
+            int key = waitKey(isIdle ? -1 : Scheduler.getWaitMillis(false, true));
+            PhaseTimer inputTimer(key != ERR ? getStats() : nullptr, Phase::Input);
+            switch (key) {
             case KEY_INS:
+                inputTimer.cancel();
+                Engine.setPaused(true);
                 editTable();
-                isStable = false;
-                lastTime = 0;
+                IsPaused = false;
+                Engine.setPaused(false);
+                Renderer.invalidate();
+                isDirty = true;
+                Scheduler.restart();
+                break;
+            case KEY_ARROW_UP:
+                pan(0, -1);
+                isDirty = true;
+                break;
+            case KEY_ARROW_DOWN:
+                pan(0, 1);
+                isDirty = true;
+                break;
+            case KEY_ARROW_LEFT:
+                pan(-1, 0);
+                isDirty = true;
+                break;
+            case KEY_ARROW_RIGHT:
+                pan(1, 0);
+                isDirty = true;
+                break;
+            case KEY_PLUS:
+                zoom(-1);
+                isDirty = true;
+                break;
+            case KEY_MINUS:
+                zoom(1);
+                isDirty = true;
+                break;
+            case KEY_I_UPPER:
+            case KEY_I_LOWER:
+                toggleStats();
+                isDirty = true;
+                break;
+            case KEY_SPACE:
+                IsPaused = !IsPaused;
+                Engine.setPaused(IsPaused);
+                if (!IsPaused)
+                    Scheduler.restart();
+                isDirty = true;
+                break;
+            case KEY_R_UPPER:
+            case KEY_R_LOWER:
+                toggleRecording();
+                isDirty = true;
                 break;
             case KEY_ESC:
                 //reset(); //нужно ли сбрасывать таблицу при выходе?
+                Engine.stop();
+                setRecorder(nullptr, 1);
+                Recording.finish();
+                Recording.wait();
+                if (Generation > 0)
+                    Checkpoints.save(CHECKPOINTFILE, getBoard(), { Generation, Population, getRuleName(), getCellStates() });
                 return;
                 break;
             default:
-                if (time(NULL) - lastTime > ITERATIONTIME and !isStable) {
-                    display();
-                    isStable = iterate();
-                    lastTime = time(NULL);
-                }
-                if (isStable) mvprintw(offsetY - 3, (COLS - 35) / 2, "Stable condition has been achieved!");
-                mvprintw(offsetY + Height + 1, (COLS - 10) / 2, "Edit - INS");
-                mvprintw(offsetY + Height + 2, (COLS - 10) / 2, "Exit - ESC");
-                mvprintw(offsetY + Height + 1, (COLS - 10) / 2 - 25, "Generation: %d", getGeneration());
-                mvprintw(offsetY + Height + 2, (COLS - 10) / 2 - 25, "Population: %d", getPopulation());
-                mvprintw(offsetY + Height + 1, (COLS - 10) / 2 + 20, "Time: %d %s", (time(NULL) - initialTime), "sec");
+                if (handleHistoryKey(key))
+                    isDirty = true;
                 break;
             }
         }
     }
 
+    // Zoomed out, a character shows the density of its block, from ' ' for an
+    // empty block to '@' for a full one. Right after zooming out the frame may
+    // not have a pyramid yet; the screen then waits for the next one.
     void display(int targetX = -1, int targetY = -1) {
-        for (int i = 0; i < ROWS; i++)
-            for (int j = 0; j < COLS; j++)
-                mvaddch(i, j, ' ');
-        for (int y = 0; y < Height + 2; y++) {
-            for (int x = 0; x < Width + 2; x++) {
-                int posX = offsetX + x;
-                int posY = offsetY + y - 2;
-                if (x == 0 or y == 0 or x == Width + 1 or y == Height + 1) {
-                    reverseColor();
-                    mvwaddch(stdscr, posY, posX, ' ');
-                    reverseColor();
-                }
+        static const char density[] = " .:-=+*#%@";
+        chtype normal = ISLIGHTMODE ? A_REVERSE : A_NORMAL;
+        uint32_t area = 1u << (2 * Zoom);
+        if (Zoom >= 3 and !getFrame().HasPyramid)
+            return;
+        Renderer.beginFrame(ROWS, COLS);
+        for (int y = 0; y < ViewRows; y++) {
+            for (int x = 0; x < ViewCols; x++) {
+                int cellX = ViewX + (x << Zoom), cellY = ViewY + (y << Zoom);
+                chtype attributes = (cellX == targetX and cellY == targetY) ? normal ^ A_REVERSE : normal;
+                char glyph;
+                if (Zoom == 0)
+                    glyph = " @+"[getFrame().getCellState(cellX, cellY)]; //'+' - умирающая клетка
                 else {
-                    if (x - 1 == targetX and y - 1 == targetY) {
-                        reverseColor();
-                        PrevGameTable[y - 1][x - 1] ? mvaddch(posY, posX, '@') : mvaddch(posY, posX, ' ');
-                        reverseColor();
-                    }
-                    else
-                        PrevGameTable[y - 1][x - 1] ? mvaddch(posY, posX, '@') : mvaddch(posY, posX, ' ');
+                    uint32_t count = countBlock(cellX, cellY);
+                    glyph = density[count == 0 ? 0 : 1 + (int)((uint64_t)(count - 1) * 9 / area)];
                 }
+                Renderer.put(offsetY + y - 1, offsetX + x + 1, glyph | attributes);
             }
         }
+        drawHistory(targetX < 0);
+        if (targetX < 0 and getFrame().IsStable)
+            drawCensus();
+        if (ShowStats and targetX < 0)
+            drawStats();
+        Renderer.endFrame();
     }
 };
 
@@ -263,13 +724,20 @@ private:
     };
 
     Game myGame{ TABLEHEIGHT, TABLEWIDTH };
-    time_t lastTime;
+    TerminalRenderer Renderer;
+    FrameScheduler TitleScheduler;
     bool isTitleRunning;
     int itemsOffset;
     int startMenuPos;
 
     void showOptions();
     void showTutorial();
+
+    //треть высоты консоли, но не ниже, чем нужно, чтобы меню опций поместилось под заголовком
+    int getStartMenuPos() const {
+        return std::max(0, std::min((int)(ROWS * 0.333) - 3, ROWS - itemsOffset - OPTIONMENUSIZE));
+    }
+    const char* describeBoundary(); //для showTutorial(), по выбранному режиму
     void showCredits();
     bool exitProgram();
 
@@ -288,25 +756,37 @@ private:
     }
 
     void displayTitle() {
-        if (isTitleRunning and time(NULL) - lastTime > ITERATIONTIME) {
+        TitleScheduler.setGenerationInterval(ITERATIONTIME);
+        if (isTitleRunning and TitleScheduler.isGenerationDue()) {
             iterate();
-            lastTime = time(NULL);
+            TitleScheduler.generationDone();
         }
+        chtype normal = ISLIGHTMODE ? A_REVERSE : A_NORMAL;
+        Renderer.beginFrame(ROWS, COLS);
         for (int y = 0; y < ROWS; y++) {
             for (int x = 0; x < COLS; x++) {
-                PrevGameTable[y][x] ? mvwaddch(stdscr, y, x, '@') : mvwaddch(stdscr, y, x, ' ');
+                Renderer.put(y, x, (PrevGameTable.get(x, y) ? '@' : ' ') | normal);
             }
         }
+        Renderer.endFrame();
+        TitleScheduler.frameDone();
+    }
+
+    // Waits for a key until the next generation of the title is due.
+    int waitTitleKey() {
+        return waitKey(TitleScheduler.getWaitMillis(isTitleRunning, false));
     }
 
-    void DispTextCenter(const char* str, int shiftY, int shiftX = 0) const {
+    // Text is printed over the title, so its row is repainted from the title next frame.
+    void DispTextCenter(const char* str, int shiftY, int shiftX = 0) {
         int currY = (ROWS / 2) + shiftY;
         int currX = ((COLS - strlen(str)) / 2) + shiftX;
         mvprintw(currY, currX, "%s", str);
+        Renderer.invalidateRows(currY, 1);
     }
 
 public:
-    MainMenu() : GameOfLife(ROWS, COLS), startMenuPos(ROWS * 0.333 - 3), itemsOffset(8), isTitleRunning(false), lastTime(0) {}
+    MainMenu() : GameOfLife(ROWS, COLS), TitleScheduler(ITERATIONTIME, FRAMERATE), isTitleRunning(false), itemsOffset(8), startMenuPos(getStartMenuPos()) {}
 
     void run() {
         int mainMenuChoice = 0;
@@ -320,8 +800,9 @@ public:
                 move(startMenuPos + itemsOffset + i, (COLS - lengthMainMenu) / 2 - 1);
                 i == mainMenuChoice ? printw(">%s", mainMenuItems[i]) : printw(" %s", mainMenuItems[i]);
             }
+            Renderer.invalidateRows(startMenuPos + itemsOffset, sizeMainMenu);
 
-            switch (getch()) {
+            switch (waitTitleKey()) {
             case KEY_END:
                 isTitleRunning = !isTitleRunning;
                 break;
@@ -336,6 +817,7 @@ public:
             case KEY_CONFIRM:
                 clear();
                 refresh();
+                Renderer.invalidate();
                 switch (mainMenuChoice) {
                 case 0:
                     myGame.run();
@@ -363,6 +845,7 @@ public:
                     updateField(0);
                     break;
                 }
+                Renderer.invalidate();
                 break;
             }
         }
@@ -370,7 +853,10 @@ public:
 };
 
 
-int main() {
+int main(int argc, char** argv) {
+    if (isHeadlessRequested(argc, argv))
+        return runHeadless(argc, argv);
+
     initscr();
     keypad(stdscr, true);
     curs_set(0);
@@ -390,7 +876,7 @@ int main() {
 
 void MainMenu::showOptions() { //реализация функции проклята
     int optionMenuChoice = 0;
-    int sizeOptionMenu = 4;
+    int sizeOptionMenu = OPTIONMENUSIZE;
     int offsetX = (COLS - 16) / 2;
     int offsetY = startMenuPos + itemsOffset;
     bool isEdit = false;
@@ -405,7 +891,7 @@ void MainMenu::showOptions() { //реализация функции прокл
         }
         else if (optionMenuChoice == 0 and isEdit) {
             mvprintw(offsetY + 0, offsetX, ">LightMode: ");
-            mvprintw(offsetY + 1, offsetX, " Iteration time: %.1f", ITERATIONTIME);
+            mvprintw(offsetY + 1, offsetX, " Iteration time: %g", ITERATIONTIME);
             mvprintw(offsetY + 2, offsetX, " Table size: %d %d", TABLEHEIGHT, TABLEWIDTH);
             mvprintw(offsetY + 3, offsetX, " Console size: %d %d", ROWS, COLS);
             move(offsetY + 0, offsetX + 12);
@@ -419,32 +905,35 @@ void MainMenu::showOptions() { //реализация функции прокл
 
         move(offsetY + 1, offsetX);
         if (optionMenuChoice == 1 and !isEdit)
-            printw(">Iteration time(sec): %.1f", ITERATIONTIME);
+            printw(">Iteration time(sec): %g", ITERATIONTIME);
         else if (optionMenuChoice == 1 and isEdit) {
             mvprintw(offsetY + 1, offsetX, ">Iteration time(sec): ");
             mvprintw(offsetY + 2, offsetX, " Table size: %d %d", TABLEHEIGHT, TABLEWIDTH);
             mvprintw(offsetY + 3, offsetX, " Console size: %d %d", ROWS, COLS);
             move(offsetY + 1, offsetX + 22);
-            double newIterationTime;
+            double newIterationTime = -1.0;
             char inputStr[15];
             echo();
+            timeout(-1);
             getstr(inputStr);
+            timeout(0);
             sscanf_s(inputStr, "%lf", &newIterationTime);
-            if (newIterationTime > 0.0)
+            if (newIterationTime >= 0.0)
                 ITERATIONTIME = newIterationTime;
             else {
                 clear();
                 attron(COLOR_PAIR(1));
-                DispTextCenter("Invalid input. Please enter positive float value.", -2);
+                DispTextCenter("Invalid input. Enter 0 (as fast as possible) or more.", -2);
                 DispTextCenter("             Press ESC to continue...            ", -1);
                 attroff(COLOR_PAIR(1));
-                while (!(getch() == KEY_ESC));
+                while (waitKey(-1) != KEY_ESC);
+                Renderer.invalidate();
             }
             noecho();
             isEdit = false;
         }
         else
-            printw(" Iteration time: %.1f", ITERATIONTIME);
+            printw(" Iteration time: %g", ITERATIONTIME);
 
         move(offsetY + 2, offsetX);
         if (optionMenuChoice == 2 and !isEdit)
@@ -455,8 +944,10 @@ void MainMenu::showOptions() { //реализация функции прокл
             move(offsetY + 2, offsetX + 18);
             int newWidth, newHeight;
             echo();
+            timeout(-1);
             scanw("%d %d", &newHeight, &newWidth);
-            if (newHeight >= 1 and newWidth >= 1 and newHeight <= 100 and newWidth <= 200) {
+            timeout(0);
+            if (newHeight >= 1 and newWidth >= 1 and newHeight <= 16384 and newWidth <= 16384) {
                 TABLEHEIGHT = newHeight;
                 TABLEWIDTH = newWidth;
                 myGame.resize(TABLEHEIGHT, TABLEWIDTH);
@@ -465,10 +956,11 @@ void MainMenu::showOptions() { //реализация функции прокл
                 clear();
                 attron(COLOR_PAIR(1));          
                 DispTextCenter("                  Invalid input                     ", -2);
-                DispTextCenter(" The range of acceptable table sizes: 1x1 - 100x200 ", -1);
+                DispTextCenter(" The range of acceptable table sizes: 1x1 - 16384x16384 ", -1);
                 DispTextCenter("              Press ESC to continue...              ",  0);
                 attroff(COLOR_PAIR(1));
-                while (!(getch() == KEY_ESC));
+                while (waitKey(-1) != KEY_ESC);
+                Renderer.invalidate();
             }
             noecho();
             isEdit = false;
@@ -484,7 +976,9 @@ void MainMenu::showOptions() { //реализация функции прокл
             move(offsetY + 3, offsetX + 20);
             int newRows, newCols;
             echo();
+            timeout(-1);
             scanw("%d %d", &newRows, &newCols);
+            timeout(0);
             if (newRows >= 20 and newCols >= 90 and newRows <= 90 and newCols <= 200) {
                 ROWS = newRows;
                 COLS = newCols;
@@ -498,17 +992,197 @@ void MainMenu::showOptions() { //реализация функции прокл
                 DispTextCenter(" The range of acceptable console sizes: 20x90 - 90x200 ", -1);
                 DispTextCenter("                Press ESC to continue...                ",  0);
                 attroff(COLOR_PAIR(1));
-                while (!(getch() == KEY_ESC));
+                while (waitKey(-1) != KEY_ESC);
+                Renderer.invalidate();
             }
             resize(ROWS, COLS);
-            startMenuPos = ROWS * 0.333 - 3;
+            startMenuPos = getStartMenuPos();
+            offsetY = startMenuPos + itemsOffset;
             noecho();
             isEdit = false;
         }
         else
             printw(" Console size: %d %d", ROWS, COLS);
 
-        switch (getch()) {
+        move(offsetY + 4, offsetX);
+        if (optionMenuChoice == 4 and isEdit) {
+            KERNELCROSSCHECK = !KERNELCROSSCHECK;
+            myGame.setCrossCheck(KERNELCROSSCHECK);
+            isEdit = false;
+        }
+        optionMenuChoice == 4 ? printw(">Kernel check(%s): [", getKernelName(myGame.getKernel())) : printw(" Kernel check: [");
+        KERNELCROSSCHECK ? printw("x]") : printw(" ]");
+
+        move(offsetY + 5, offsetX);
+        if (optionMenuChoice == 5 and !isEdit)
+            printw(">Threads: %d", THREADCOUNT);
+        else if (optionMenuChoice == 5 and isEdit) {
+            int maxThreads = std::max(1, (int)std::thread::hardware_concurrency());
+            mvprintw(offsetY + 5, offsetX, ">Threads(1-%d): ", maxThreads);
+            int newThreads;
+            echo();
+            timeout(-1);
+            scanw("%d", &newThreads);
+            timeout(0);
+            if (newThreads >= 1 and newThreads <= maxThreads) {
+                THREADCOUNT = newThreads;
+                myGame.setThreadCount(THREADCOUNT);
+            }
+            else {
+                clear();
+                attron(COLOR_PAIR(1));
+                DispTextCenter("                 Invalid input                  ", -2);
+                DispTextCenter(" The number of threads must not exceed CPU cores ", -1);
+                DispTextCenter("            Press ESC to continue...            ",  0);
+                attroff(COLOR_PAIR(1));
+                while (waitKey(-1) != KEY_ESC);
+                Renderer.invalidate();
+            }
+            noecho();
+            isEdit = false;
+        }
+        else
+            printw(" Threads: %d", THREADCOUNT);
+
+        move(offsetY + 6, offsetX);
+        if (optionMenuChoice == 6 and !isEdit)
+            HASHLIFESTEP < 0 ? printw(">HashLife step: off") : printw(">HashLife step: 2^%d", HASHLIFESTEP);
+        else if (optionMenuChoice == 6 and isEdit) {
+            mvprintw(offsetY + 6, offsetX, ">HashLife step(2^k, -1 off): ");
+            int newStep;
+            echo();
+            timeout(-1);
+            scanw("%d", &newStep);
+            timeout(0);
+            if (newStep >= -1 and newStep <= 56) {
+                HASHLIFESTEP = newStep;
+                myGame.setHashLifeStep(HASHLIFESTEP);
+            }
+            else {
+                clear();
+                attron(COLOR_PAIR(1));
+                DispTextCenter("                Invalid input                ", -2);
+                DispTextCenter(" The range of acceptable HashLife steps: -1-56 ", -1);
+                DispTextCenter("           Press ESC to continue...          ",  0);
+                attroff(COLOR_PAIR(1));
+                while (waitKey(-1) != KEY_ESC);
+                Renderer.invalidate();
+            }
+            noecho();
+            isEdit = false;
+        }
+        else
+            HASHLIFESTEP < 0 ? printw(" HashLife step: off") : printw(" HashLife step: 2^%d", HASHLIFESTEP);
+
+        move(offsetY + 7, offsetX);
+        if (optionMenuChoice == 7 and isEdit) {
+            UNBOUNDED = !UNBOUNDED;
+            myGame.setUnbounded(UNBOUNDED);
+            isEdit = false;
+        }
+        optionMenuChoice == 7 ? printw(">Unbounded: [") : printw(" Unbounded: [");
+        UNBOUNDED ? printw("x]") : printw(" ]");
+
+        move(offsetY + 8, offsetX);
+        if (optionMenuChoice == 8 and !isEdit)
+            printw(">Rule: %s", myGame.getRuleName().c_str());
+        else if (optionMenuChoice == 8 and isEdit) {
+            mvprintw(offsetY + 8, offsetX, ">Rule: ");
+            clrtoeol();
+            char inputStr[64];
+            LifeRule newRule;
+            echo();
+            timeout(-1);
+            getnstr(inputStr, sizeof(inputStr) - 1);
+            timeout(0);
+            if (parseRule(inputStr, newRule))
+                myGame.setRule(newRule);
+            else {
+                clear();
+                attron(COLOR_PAIR(1));
+                DispTextCenter("                    Invalid input                     ", -2);
+                DispTextCenter(" Rules: B3/S23, B2/S/C3 or R5,C0,M1,S34..58,B34..45,NM ", -1);
+                DispTextCenter("               Press ESC to continue...               ",  0);
+                attroff(COLOR_PAIR(1));
+                while (waitKey(-1) != KEY_ESC);
+            }
+            Renderer.invalidate();
+            noecho();
+            isEdit = false;
+        }
+        else
+            printw(" Rule: %s", myGame.getRuleName().c_str());
+
+        move(offsetY + 9, offsetX);
+        if (optionMenuChoice == 9 and !isEdit)
+            printw(">History: %d MB", HISTORYMEGABYTES);
+        else if (optionMenuChoice == 9 and isEdit) {
+            mvprintw(offsetY + 9, offsetX, ">History(MB, 0 off): ");
+            int newMegabytes;
+            echo();
+            timeout(-1);
+            scanw("%d", &newMegabytes);
+            timeout(0);
+            if (newMegabytes >= 0 and newMegabytes <= 65536) {
+                HISTORYMEGABYTES = newMegabytes;
+                myGame.setHistoryBudget((size_t)HISTORYMEGABYTES << 20);
+            }
+            else {
+                clear();
+                attron(COLOR_PAIR(1));
+                DispTextCenter("              Invalid input               ", -2);
+                DispTextCenter("   The history takes from 0 to 65536 MB   ", -1);
+                DispTextCenter("         Press ESC to continue...         ",  0);
+                attroff(COLOR_PAIR(1));
+                while (waitKey(-1) != KEY_ESC);
+                Renderer.invalidate();
+            }
+            noecho();
+            isEdit = false;
+        }
+        else
+            printw(" History: %d MB", HISTORYMEGABYTES);
+
+        move(offsetY + 10, offsetX);
+        if (optionMenuChoice == 10 and !isEdit)
+            printw(">Processes: %d", PROCESSCOUNT);
+        else if (optionMenuChoice == 10 and isEdit) {
+            mvprintw(offsetY + 10, offsetX, ">Processes(1-64): ");
+            int newProcesses;
+            echo();
+            timeout(-1);
+            scanw("%d", &newProcesses);
+            timeout(0);
+            if (newProcesses >= 1 and newProcesses <= 64) {
+                PROCESSCOUNT = newProcesses;
+                myGame.setProcessCount(PROCESSCOUNT);
+            }
+            else {
+                clear();
+                attron(COLOR_PAIR(1));
+                DispTextCenter("              Invalid input               ", -2);
+                DispTextCenter("  The board is split into 1 to 64 strips  ", -1);
+                DispTextCenter("         Press ESC to continue...         ",  0);
+                attroff(COLOR_PAIR(1));
+                while (waitKey(-1) != KEY_ESC);
+                Renderer.invalidate();
+            }
+            noecho();
+            isEdit = false;
+        }
+        else
+            printw(" Processes: %d", PROCESSCOUNT);
+
+        move(offsetY + 11, offsetX);
+        if (optionMenuChoice == 11 and isEdit) {
+            myGame.setBoundary((BoundaryKind)(((int)myGame.getBoundary() + 1) % 4));
+            isEdit = false;
+        }
+        printw(optionMenuChoice == 11 ? ">Boundary: %s" : " Boundary: %s", getBoundaryName(myGame.getBoundary()));
+
+        Renderer.invalidateRows(offsetY, sizeOptionMenu);
+
+        switch (waitTitleKey()) {
         case KEY_UP:
             if (optionMenuChoice > 0) optionMenuChoice--;
             else optionMenuChoice = sizeOptionMenu - 1;
@@ -530,16 +1204,33 @@ void MainMenu::showOptions() { //реализация функции прокл
     }
 }
 
+const char* MainMenu::describeBoundary() {
+    if (myGame.getHashLifeStep() >= 0 or myGame.isUnbounded())
+        return "The game has no boundaries, the plane is endless. Press the END key)";
+    if (!myGame.getRule().isLifeLike())
+        return "The boundaries of the game are interconnected. Press the END key)";
+    switch (myGame.getBoundary()) {
+    case BoundaryKind::Dead:
+        return "Cells beyond the boundaries of the game are dead. Press the END key)";
+    case BoundaryKind::Klein:
+        return "Boundaries are interconnected, top and bottom mirrored (Klein bottle). Press the END key)";
+    case BoundaryKind::Cylinder:
+        return "Left and right boundaries are interconnected, top and bottom are dead. Press the END key)";
+    default:
+        return "The boundaries of the game are interconnected. Press the END key)";
+    }
+}
+
 void MainMenu::showTutorial() {
     while (true) {
         displayTitle();
         DispTextCenter("This is the game of life", 0);
         DispTextCenter("A dead cell comes to life if there are 3 living cells near it", 1);
         DispTextCenter("A living cell dies if there are less than 2 and more than 3 living cells near it", 2);
-        DispTextCenter("The boundaries of the game are interconnected. Press the END key)", 3);
+        DispTextCenter(describeBoundary(), 3);
         DispTextCenter("Press ESC to exit...", 4);
 
-        switch (getch()) {
+        switch (waitTitleKey()) {
         case KEY_END:
             isTitleRunning = !isTitleRunning;
             break;
@@ -556,7 +1247,7 @@ void MainMenu::showCredits() {
         DispTextCenter("Chernikov A.M. 20.11.2023 - 07.05.2024", 0, -1);
         DispTextCenter("Press ESC to exit...", 1, -1);
 
-        switch (getch()) {
+        switch (waitTitleKey()) {
         case KEY_END:
             isTitleRunning = !isTitleRunning;
             break;
@@ -572,7 +1263,7 @@ bool MainMenu::exitProgram() {
         displayTitle();
         DispTextCenter("Do you want to exit? Y/N", 0, -1);
 
-        int key = getch();
+        int key = waitTitleKey();
         if (key == KEY_END)
             isTitleRunning = !isTitleRunning;
         else if (key == KEY_N_LOWER or key == KEY_N_UPPER or key == KEY_ESC)
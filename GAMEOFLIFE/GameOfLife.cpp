@@ -0,0 +1,367 @@
+#include "GameOfLife.h"
+#include <algorithm>
+
+constexpr int GameOfLife::TILESIZE;
+
+GameOfLife::GameOfLife(int height, int width) : Width(width), Height(height), Generation(0), Population(0), CurrGameTable(height, width), PrevGameTable(height, width), Kernel(detectBestKernel()), CrossCheck(false), KernelMismatches(0), HashLifeStepLog(-1), UniverseLoaded(false), Unbounded(false), PlaneLoaded(false), ProcessCount(1), ClusterLoaded(false), TableStale(false), Masks(CONWAYRULE), Boundary(BoundaryKind::Torus), StatesLoaded(false), Stats(nullptr), BoardHash(0), BoardHashValid(false), Period(0), CycleStart(0), PyramidValid(false), JournalStale(true), Recorder(nullptr), RecordEvery(1), NextRecord(0) {
+    resizeTiles();
+}
+
+void GameOfLife::resizeTiles() {
+    TilesX = PrevGameTable.getWordsPerRow();
+    TilesY = (Height + TILESIZE - 1) / TILESIZE;
+    TileChanged.assign(TilesX * TilesY, 0);
+    TileActive.assign(TilesX * TilesY, 0);
+    TilePopulation.assign(TilesX * TilesY, 0);
+    TileFlips.assign(TilesX * TilesY, 0);
+    TileRowHash.assign(TilesY, 0);
+    Pyramid.resize(Height, Width);
+    AllTilesDirty = true;
+}
+
+// Neighbors are taken around the torus whatever the boundary: at worst a tile
+// more is stepped. On the Klein bottle a change at the top or bottom edge
+// reappears mirrored at the other, so the whole opposite row of tiles is stepped.
+bool GameOfLife::computeActiveTiles() {
+    if (AllTilesDirty) {
+        std::fill(TileActive.begin(), TileActive.end(), 1);
+        AllTilesDirty = false;
+        return true;
+    }
+    bool anyActive = false;
+    for (int ty = 0; ty < TilesY; ty++) {
+        for (int tx = 0; tx < TilesX; tx++) {
+            uint8_t active = 0;
+            for (int dy = -1; dy <= 1; dy++)
+                for (int dx = -1; dx <= 1; dx++)
+                    active |= TileChanged[((ty + dy + TilesY) % TilesY) * TilesX + (tx + dx + TilesX) % TilesX];
+            TileActive[ty * TilesX + tx] = active;
+            anyActive = anyActive or active;
+        }
+    }
+    if (Boundary == BoundaryKind::Klein) {
+        uint8_t* top = &TileActive[0];
+        uint8_t* bottom = &TileActive[(size_t)(TilesY - 1) * TilesX];
+        bool topChanged = std::any_of(TileChanged.begin(), TileChanged.begin() + TilesX, [](uint8_t changed) { return changed != 0; });
+        bool bottomChanged = std::any_of(TileChanged.end() - TilesX, TileChanged.end(), [](uint8_t changed) { return changed != 0; });
+        if (bottomChanged)
+            std::fill(top, top + TilesX, 1);
+        if (topChanged)
+            std::fill(bottom, bottom + TilesX, 1);
+    }
+    return anyActive;
+}
+
+void GameOfLife::stepTileRow(int ty) {
+    int first = ty * TilesX;
+    int yBegin = ty * TILESIZE;
+    int yEnd = std::min(Height, yBegin + TILESIZE);
+    int tx = 0;
+    TileRowHash[ty] = 0;
+    while (tx < TilesX) {
+        if (!TileActive[first + tx]) {
+            TileChanged[first + tx] = 0;
+            tx++;
+            continue;
+        }
+        int spanEnd = tx;
+        while (spanEnd < TilesX and TileActive[first + spanEnd])
+            spanEnd++;
+        std::fill(TileFlips.begin() + first + tx, TileFlips.begin() + first + spanEnd, 0);
+        std::fill(TilePopulation.begin() + first + tx, TilePopulation.begin() + first + spanEnd, 0);
+        stepSpan(PrevGameTable, CurrGameTable, yBegin, yEnd, tx, spanEnd, Kernel, &TileFlips[first], &TilePopulation[first], Masks);
+        for (; tx < spanEnd; tx++) {
+            TileChanged[first + tx] = TileFlips[first + tx] != 0;
+            if (!TileChanged[first + tx])
+                continue;
+            for (int y = yBegin; y < yEnd; y++)
+                TileRowHash[ty] ^= hashWord(PrevGameTable.row(y)[tx] ^ CurrGameTable.row(y)[tx], (uint64_t)y * Width + tx * 64);
+            if (PyramidValid)
+                Pyramid.updateTile(CurrGameTable, tx, ty);
+        }
+    }
+}
+
+StepResult GameOfLife::stepTiles() {
+    if (computeActiveTiles()) {
+        if (Pool and Pool->getThreadCount() > 1 and TilesY > 1)
+            Pool->parallelFor(TilesY, [&](int ty) { stepTileRow(ty); });
+        else
+            for (int ty = 0; ty < TilesY; ty++)
+                stepTileRow(ty);
+    }
+    else
+        std::fill(TileRowHash.begin(), TileRowHash.end(), 0);
+    StepResult result = { 0, false };
+    for (int i = 0; i < TilesX * TilesY; i++) {
+        result.Population += TilePopulation[i];
+        result.Changed = result.Changed or TileChanged[i];
+    }
+    return result;
+}
+
+bool GameOfLife::iterateHashLife() {
+    if (!UniverseLoaded) {
+        Universe.load(PrevGameTable, Generation);
+        UniverseLoaded = true;
+    }
+    bool isStable = Universe.step(HashLifeStepLog);
+    Generation = (long long)Universe.getGeneration();
+    Population = (long long)Universe.getPopulation();
+    Universe.render(PrevGameTable);
+    PyramidValid = false;
+    return isStable;
+}
+
+bool GameOfLife::iterateUnbounded() {
+    if (!PlaneLoaded) {
+        Plane.load(PrevGameTable, Generation);
+        PlaneLoaded = true;
+    }
+    bool isStable = Plane.step();
+    Generation = (long long)Plane.getGeneration();
+    Population = (long long)Plane.getPopulation();
+    Plane.render(PrevGameTable);
+    PyramidValid = false;
+    return isStable;
+}
+
+bool GameOfLife::iterateCluster() {
+    if (!ClusterLoaded) {
+        if (!Cluster.start(PrevGameTable, ProcessCount, Kernel, Masks, Boundary)) {
+            ProcessCount = 1;
+            return iterateTable();
+        }
+        ClusterLoaded = true;
+    }
+    StepResult result;
+    if (!Cluster.step(result)) {
+        // The generation before is still in the strips of the workers left.
+        syncTable();
+        Cluster.stop();
+        ProcessCount = 1;
+        ClusterLoaded = false;
+        return iterateTable();
+    }
+    TableStale = true;
+    Population = result.Population;
+    Generation++;
+    PyramidValid = false;
+    BoardHashValid = false;
+    return !result.Changed;
+}
+
+bool GameOfLife::iterateStates() {
+    if (!StatesLoaded) {
+        States.load(PrevGameTable);
+        StatesLoaded = true;
+    }
+    StepResult result = States.step(Rule, Pool.get());
+    States.render(PrevGameTable);
+    Population = result.Population;
+    Generation++;
+    PyramidValid = false;
+    BoardHashValid = false;
+    return !result.Changed;
+}
+
+void GameOfLife::setRule(const LifeRule& rule) {
+    syncTable();
+    Rule = rule;
+    Masks = Rule.isLifeLike() ? RuleMasks{ Rule.getBirthMask(), Rule.getSurvivalMask() } : CONWAYRULE;
+    Universe.setRule(Masks);
+    Plane.setRule(Masks);
+    markEdited();
+}
+
+void GameOfLife::setBoard(const BitBoard& board) {
+    if (board.getWidth() != Width or board.getHeight() != Height)
+        resize(board.getHeight(), board.getWidth());
+    PrevGameTable = board;
+    Population = board.countPopulation();
+    markEdited();
+}
+
+std::vector<uint8_t> GameOfLife::getCellStates() const {
+    if (!StatesLoaded or Rule.States <= 2)
+        return std::vector<uint8_t>();
+    return States.getCells();
+}
+
+bool GameOfLife::setCellStates(const std::vector<uint8_t>& states) {
+    if (Rule.States <= 2 or states.size() != (size_t)Width * Height)
+        return false;
+    for (uint8_t state : states)
+        if (state >= Rule.States)
+            return false;
+    markEdited();
+    States.loadCells(Height, Width, states);
+    States.render(PrevGameTable);
+    StatesLoaded = true;
+    Population = PrevGameTable.countPopulation();
+    return true;
+}
+
+const PopulationPyramid& GameOfLife::getPyramid() {
+    syncTable();
+    if (!PyramidValid) {
+        Pyramid.rebuild(PrevGameTable);
+        PyramidValid = true;
+    }
+    return Pyramid;
+}
+
+size_t GameOfLife::getMemoryUsage() const {
+    size_t tiles = TileChanged.capacity() + TileActive.capacity() + TilePopulation.capacity() * sizeof(int) + (TileFlips.capacity() + TileRowHash.capacity()) * sizeof(uint64_t);
+    return CurrGameTable.getMemoryUsage() + PrevGameTable.getMemoryUsage() + CheckGameTable.getMemoryUsage() + tiles + History.getMemoryUsage() + Universe.getMemoryUsage() + Plane.getMemoryUsage() + Pyramid.getMemoryUsage() + States.getMemoryUsage() + Journal.getMemoryUsage() + JournalBefore.getMemoryUsage() + Cluster.getMemoryUsage();
+}
+
+void GameOfLife::setThreadCount(int threads) {
+    if (threads <= 1)
+        Pool.reset();
+    else if (!Pool)
+        Pool.reset(new ThreadPool(threads));
+    else
+        Pool->setThreadCount(threads);
+}
+
+bool GameOfLife::iterateTable() {
+    if (!BoardHashValid) {
+        PhaseTimer timer(Stats, Phase::StableCheck);
+        BoardHash = hashBoard(PrevGameTable);
+        History.clear();
+        History.record(BoardHash, Generation);
+        BoardHashValid = true;
+    }
+    StepResult result;
+    {
+        PhaseTimer timer(Stats, Phase::Step);
+        fillGhostCells(PrevGameTable, Boundary);
+        result = stepTiles();
+        if (PyramidValid)
+            Pyramid.propagate(TileChanged, TilesX, TilesY);
+        if (CrossCheck and Kernel != KernelKind::Scalar) {
+            if (CheckGameTable.getWidth() != Width or CheckGameTable.getHeight() != Height)
+                CheckGameTable.resize(Height, Width);
+            StepResult reference = stepBoard(PrevGameTable, CheckGameTable, KernelKind::Scalar, Masks, Boundary);
+            if (reference.Population != result.Population or reference.Changed != result.Changed or CheckGameTable != CurrGameTable)
+                KernelMismatches++;
+        }
+    }
+    Population = result.Population;
+    Generation++;
+    if (Journal.isEnabled())
+        Journal.addStep(PrevGameTable, CurrGameTable, Generation, TileChanged.data(), TilesX, TILESIZE);
+    PrevGameTable.swap(CurrGameTable);
+    PhaseTimer timer(Stats, Phase::StableCheck);
+    for (uint64_t rowHash : TileRowHash)
+        BoardHash ^= rowHash;
+    if (Period == 0) {
+        long long seenAt = History.record(BoardHash, Generation);
+        if (seenAt >= 0) {
+            Period = Generation - seenAt;
+            CycleStart = seenAt;
+        }
+    }
+    return !result.Changed;
+}
+
+bool GameOfLife::iterate() {
+    CountedAllocations counted;
+    long long generation = Generation;
+    bool isJournaled = Journal.isEnabled() and !isWindowOfPlane();
+    if (isJournaled) {
+        syncTable();
+        if (JournalStale or Journal.isEmpty())
+            Journal.addKeyframe(PrevGameTable, Generation);
+        else if (Journal.getLastGeneration() != Generation)
+            Journal.truncateAfter(Generation);
+        JournalStale = false;
+    }
+    bool isStable;
+    if (Rule.isLifeLike() and HashLifeStepLog < 0 and !Unbounded and ProcessCount <= 1)
+        isStable = iterateTable();
+    else {
+        if (isJournaled)
+            JournalBefore = PrevGameTable;
+        {
+            PhaseTimer timer(Stats, Phase::Step);
+            if (!Rule.isLifeLike())
+                isStable = iterateStates();
+            else if (HashLifeStepLog >= 0)
+                isStable = iterateHashLife();
+            else if (Unbounded)
+                isStable = iterateUnbounded();
+            else
+                isStable = iterateCluster();
+        }
+        if (isJournaled) {
+            syncTable();
+            Journal.addStep(JournalBefore, PrevGameTable, Generation);
+        }
+    }
+    if (Recorder and Generation >= NextRecord) {
+        syncTable();
+        Recorder->push(PrevGameTable, Generation);
+        NextRecord = Generation + RecordEvery;
+    }
+    if (Stats)
+        Stats->recordGenerations(Generation, Generation - generation, Population, (double)Width * Height);
+    return isStable;
+}
+
+void GameOfLife::takeCensus(ObjectCensus& census) {
+    syncTable();
+    std::vector<BitBoard> phases(1, PrevGameTable);
+    if (Rule.isLifeLike() and Period > 1 and Period <= ObjectCensus::MAXPHASES) {
+        phases.resize((size_t)Period);
+        for (long long phase = 1; phase < Period; phase++) {
+            phases[phase] = BitBoard(Height, Width);
+            stepBoard(phases[phase - 1], phases[phase], Kernel, Masks, Boundary);
+        }
+    }
+    // Hashlife and the unbounded mode show a window of the plane. Objects
+    // across the edges of other boundaries are counted in pieces.
+    census.take(phases, HashLifeStepLog < 0 and !Unbounded and (Boundary == BoundaryKind::Torus or !Rule.isLifeLike()), Rule == LifeRule(), Pool.get());
+}
+
+void GameOfLife::setRecorder(AnimationWriter* recorder, long long every) {
+    Recorder = recorder;
+    RecordEvery = std::max(1LL, every);
+    if (Recorder) {
+        syncTable();
+        Recorder->push(PrevGameTable, Generation);
+        NextRecord = Generation + RecordEvery;
+    }
+}
+
+long long GameOfLife::seekGeneration(long long generation) {
+    if (isWindowOfPlane())
+        return -1;
+    long long reached = Journal.seek(generation, CurrGameTable);
+    if (reached < 0)
+        return -1;
+    PrevGameTable.swap(CurrGameTable);
+    Generation = reached;
+    Population = PrevGameTable.countPopulation();
+    markEdited();
+    JournalStale = false;
+    return reached;
+}
+
+void GameOfLife::reset() {
+    PrevGameTable.clear();
+    Generation = 0;
+    Population = 0;
+    markEdited();
+}
+
+void GameOfLife::resize(int newHeight, int newWidth) {
+    syncTable();
+    Height = newHeight;
+    Width = newWidth;
+    CurrGameTable.resize(Height, Width);
+    PrevGameTable.resize(Height, Width);
+    resizeTiles();
+    markEdited();
+}
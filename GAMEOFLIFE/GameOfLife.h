@@ -0,0 +1,328 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <string>
+#include "BitBoard.h"
+#include "LifeKernel.h"
+#include "LifeRule.h"
+#include "StateBoard.h"
+#include "ThreadPool.h"
+#include "HashLife.h"
+#include "SparseUniverse.h"
+#include "BoardHash.h"
+#include "PopulationPyramid.h"
+#include "Instrumentation.h"
+#include "HistoryJournal.h"
+#include "StripCluster.h"
+#include "AnimationExport.h"
+#include "ObjectCensus.h"
+
+// The simulation itself, without any user interface: the board and what
+// lies beyond its edges, the rule, the stepping kernels, the thread pool, period detection and the
+// Hashlife mode. The curses UI derives from it, the headless mode uses it directly.
+class GameOfLife {
+protected:
+    int Width, Height;
+    long long Generation, Population;
+    BitBoard CurrGameTable;
+    BitBoard PrevGameTable;
+    BitBoard CheckGameTable;
+    KernelKind Kernel;
+    bool CrossCheck;
+    int KernelMismatches;
+    std::unique_ptr<ThreadPool> Pool;
+    HashLife Universe;
+    int HashLifeStepLog;
+    bool UniverseLoaded;
+    SparseUniverse Plane;
+    bool Unbounded;
+    bool PlaneLoaded;
+    StripCluster Cluster;
+    int ProcessCount;
+    bool ClusterLoaded;
+    bool TableStale; // the cluster is ahead of PrevGameTable until syncTable()
+    LifeRule Rule;
+    RuleMasks Masks; // of Rule, when it is Life-like
+    BoundaryKind Boundary;
+
+    // Cells of the Generations and Larger than Life rules, which do not fit in
+    // one bit. PrevGameTable mirrors their live cells.
+    StateBoard States;
+    bool StatesLoaded;
+
+    // Not owned; null when nothing is measured.
+    Instrumentation* Stats;
+
+    // The board is split into tiles of TILESIZE rows by one word (64 cells).
+    // Only tiles that changed in the last generation or border such a tile are
+    // recomputed; a skipped tile already holds the same cells in both tables.
+    static constexpr int TILESIZE = 64;
+    int TilesX, TilesY;
+    std::vector<uint8_t> TileChanged;
+    std::vector<uint8_t> TileActive;
+    std::vector<int> TilePopulation;
+    std::vector<uint64_t> TileFlips;
+    std::vector<uint64_t> TileRowHash;
+    bool AllTilesDirty;
+
+    // Zobrist hash of PrevGameTable, updated from the cells that flipped.
+    uint64_t BoardHash;
+    bool BoardHashValid;
+    HashHistory History;
+    long long Period, CycleStart;
+
+    // Block populations for zoomed-out views. Kept up to date by stepTileRow()
+    // once somebody asked for them; any other change of the table invalidates them.
+    PopulationPyramid Pyramid;
+    bool PyramidValid;
+
+    // Past generations for rewinding. Stale after an edit: the next iterate()
+    // then keyframes the edited board, dropping the history after it.
+    HistoryJournal Journal;
+    bool JournalStale;
+    BitBoard JournalBefore; // the board before a step that does not run on the table
+
+    // Not owned; gets every RecordEvery-th generation while not null.
+    AnimationWriter* Recorder;
+    long long RecordEvery, NextRecord;
+
+    void resizeTiles();
+    bool computeActiveTiles();
+
+    // Steps the active tiles of one row of tiles, consecutive active tiles in one span.
+    // Rows of tiles only read PrevGameTable, so they can run in parallel.
+    void stepTileRow(int ty);
+    StepResult stepTiles();
+
+    // Must be called after PrevGameTable was changed from outside iterate(),
+    // and syncTable() before it unless the whole table was overwritten.
+    void markEdited() {
+        UniverseLoaded = false;
+        StatesLoaded = false;
+        PlaneLoaded = false;
+        ClusterLoaded = false;
+        TableStale = false;
+        AllTilesDirty = true;
+        BoardHashValid = false;
+        PyramidValid = false;
+        JournalStale = true;
+        Period = 0;
+    }
+
+    // Hashlife and the unbounded mode step a plane the table is only a window
+    // of. The history is not kept for them: a recorded window cannot give back
+    // the cells outside it.
+    bool isWindowOfPlane() const { return Rule.isLifeLike() and (HashLifeStepLog >= 0 or Unbounded); }
+
+    // The strips are only gathered into the table when it is read or edited.
+    void syncTable() {
+        if (TableStale)
+            Cluster.gather(PrevGameTable);
+        TableStale = false;
+    }
+
+    void changeCell(const int& x, const int& y) {
+        syncTable();
+        if (x >= 0 && y >= 0 && x < Width && y < Height)
+            PrevGameTable.toggle(x, y);
+        markEdited();
+    }
+
+    // Hashlife evolves the pattern on an unbounded plane instead of the torus;
+    // the table shows the part of the plane it covers.
+    bool iterateHashLife();
+
+    // Same for the chunked plane of the unbounded mode.
+    bool iterateUnbounded();
+
+    // The board in strips stepped by worker processes, without tile skipping
+    // and period detection. Falls back to iterateTable() when the processes
+    // cannot be started or one of them died.
+    bool iterateCluster();
+
+    // Rules that are not Life-like, on the byte-per-cell board.
+    bool iterateStates();
+
+    // The table with tile skipping and period detection.
+    bool iterateTable();
+
+public:
+    GameOfLife(int height, int width);
+
+    int getWidth() const { return Width; }
+
+    int getHeight() const { return Height; }
+
+    // The latest generation.
+    const BitBoard& getBoard() {
+        syncTable();
+        return PrevGameTable;
+    }
+
+    // Replaces the board, taking over its dimensions. The generation counter is kept.
+    void setBoard(const BitBoard& board);
+
+    long long getGeneration() const { return Generation; }
+
+    // For resuming a run from a checkpoint.
+    void setGeneration(long long generation) {
+        syncTable();
+        Generation = generation;
+        markEdited();
+    }
+
+    const LifeRule& getRule() const { return Rule; }
+
+    std::string getRuleName() const { return formatRule(Rule); }
+
+    // Life-like rules keep every mode; Generations and Larger than Life rules
+    // always step the torus, Hashlife and the unbounded mode being ignored.
+    void setRule(const LifeRule& rule);
+
+    // 0 dead, 1 alive, 2 and more dying (Generations rules only).
+    int getCellState(int x, int y) const {
+        return StatesLoaded ? States.get(x, y) : PrevGameTable.get(x, y);
+    }
+
+    long long getPopulation() const { return Population; }
+
+    // Every cell's state, row after row, when the rule has dying states (see
+    // getCellState()); empty when the cells are only alive or dead, as the
+    // board then holds them all.
+    std::vector<uint8_t> getCellStates() const;
+
+    // Restores what getCellStates() returned, after setBoard() and setRule()
+    // with the same size and rule. False when the states do not fit them.
+    bool setCellStates(const std::vector<uint8_t>& states);
+
+    const PopulationPyramid& getPyramid();
+
+    // Period of the cycle the board has entered, 0 while no repetition was seen.
+    // A still life has period 1. Detection covers periods up to the capacity of
+    // the hash history.
+    long long getPeriod() const { return Period; }
+
+    long long getCycleStart() const { return CycleStart; }
+
+    KernelKind getKernel() const { return Kernel; }
+
+    void setKernel(KernelKind kind) { Kernel = isKernelSupported(kind) ? kind : KernelKind::Scalar; }
+
+    // The kernel that actually runs: the vector kernels implement B3/S23 only.
+    KernelKind getActiveKernel() const { return Masks == CONWAYRULE ? Kernel : KernelKind::Scalar; }
+
+    // In cross-check mode every generation is also computed by the scalar
+    // reference kernel and any difference from the fast kernel is counted.
+    void setCrossCheck(bool enabled) { CrossCheck = enabled; }
+
+    int getKernelMismatches() const { return KernelMismatches; }
+
+    int getThreadCount() const { return Pool ? Pool->getThreadCount() : 1; }
+
+    // The pool is persistent: its threads are started here, not per generation.
+    void setThreadCount(int threads);
+
+    // Bytes held by the tables, the tile state, the hash history and the Hashlife universe.
+    size_t getMemoryUsage() const;
+
+    int getHashLifeStep() const { return HashLifeStepLog; }
+
+    // stepLog >= 0 switches iterate() to Hashlife, advancing 2^stepLog
+    // generations per call; -1 switches back to stepping the table.
+    void setHashLifeStep(int stepLog) {
+        syncTable();
+        if ((HashLifeStepLog < 0) != (stepLog < 0))
+            markEdited();
+        HashLifeStepLog = stepLog;
+    }
+
+    BoundaryKind getBoundary() const { return Boundary; }
+
+    // The edges of the table (see BoundaryKind), the torus by default. Rules
+    // that are not Life-like always step the torus; Hashlife and the
+    // unbounded mode have no edges at all.
+    void setBoundary(BoundaryKind boundary) {
+        syncTable();
+        if (Boundary != boundary)
+            markEdited();
+        Boundary = boundary;
+    }
+
+    bool isUnbounded() const { return Unbounded; }
+
+    // Unbounded mode steps an infinite plane made of chunks instead of the torus,
+    // so patterns no longer wrap into themselves. Hashlife, when on, takes precedence.
+    void setUnbounded(bool enabled) {
+        syncTable();
+        if (Unbounded != enabled)
+            markEdited();
+        Unbounded = enabled;
+    }
+
+    size_t getChunkCount() const { return Plane.getChunkCount(); }
+
+    int getProcessCount() const { return ProcessCount; }
+
+    // More than one process steps Life-like rules on the table in strips, one
+    // worker process each (Linux only); Hashlife and the unbounded mode take
+    // precedence. The workers are started on the next generation after any
+    // change of the board and stay until the next change.
+    void setProcessCount(int processes) {
+        syncTable();
+        if (ProcessCount != processes)
+            markEdited();
+        ProcessCount = std::max(1, processes);
+        if (ProcessCount == 1)
+            Cluster.stop();
+    }
+
+    // Workers actually running, 0 when the strips are not in use.
+    int getClusterProcesses() const { return Cluster.isRunning() ? Cluster.getProcessCount() : 0; }
+
+    int getClusterNodes() const { return Cluster.getNodeCount(); }
+
+    // Step and stable-check times and every generation go to stats; nullptr
+    // turns the measurements off.
+    void setInstrumentation(Instrumentation* stats) { Stats = stats; }
+
+    const Instrumentation* getInstrumentation() const { return Stats; }
+
+    // The new generation is written into CurrGameTable and the tables are swapped,
+    // so PrevGameTable always holds the latest state.
+    bool iterate();
+
+    // Adds the objects of the board to census. Objects are grouped by all the
+    // phases of the period when iterate() found one of at most
+    // ObjectCensus::MAXPHASES generations; they are stepped on a copy.
+    void takeCensus(ObjectCensus& census);
+
+    // From now on the board goes to recorder every `every` generations, starting
+    // with the current one; nullptr stops. Only the board is copied here, the
+    // encoding runs on the writer's thread.
+    void setRecorder(AnimationWriter* recorder, long long every);
+
+    // 0 turns the history off and drops it.
+    void setHistoryBudget(size_t bytes) { Journal.setBudget(bytes); }
+
+    long long getHistoryFirst() const { return Journal.getFirstGeneration(); }
+
+    long long getHistoryLast() const { return Journal.getLastGeneration(); }
+
+    size_t getHistoryMemoryUsage() const { return Journal.getMemoryUsage(); }
+
+    // Goes back (or forward again) to the latest recorded generation at or
+    // before the given one and returns it, -1 when the history starts later.
+    // The history is kept, so seeking again works until the next edit or
+    // until iterate() continues from there. For Generations rules only the
+    // live cells are recorded; the dying ones are lost on seeking. Hashlife
+    // and the unbounded mode cannot seek and always return -1.
+    long long seekGeneration(long long generation);
+
+    // The recorded generation after the current one, -1 if there is none.
+    long long getNextRecordedGeneration() const { return Journal.getNextGeneration(Generation); }
+
+    void reset();
+
+    void resize(int newHeight, int newWidth);
+};
@@ -0,0 +1,364 @@
+#include "HashLife.h"
+
+static constexpr uint8_t FREELEVEL = 255;
+
+constexpr uint32_t HashLife::NONE;
+constexpr uint32_t HashLife::DEAD;
+constexpr uint32_t HashLife::ALIVE;
+constexpr int HashLife::MAXLEVEL;
+
+HashLife::HashLife(size_t memoryBudgetBytes) : LiveNodes(3), MaxNodes(0), NodeLimit(SIZE_MAX), Overflow(false), Root(NONE), OriginX(0), OriginY(0), Rule(CONWAYRULE), Generation(0) {
+    setMemoryBudget(memoryBudgetBytes);
+    Node leaf = { NONE, NONE, NONE, NONE, NONE, NONE, 0, 0, -1, false };
+    Nodes.push_back(leaf);
+    Nodes.push_back(leaf);
+    leaf.Population = 1;
+    Nodes.push_back(leaf);
+    Buckets.assign(1 << 16, NONE);
+    EmptyNodes.push_back(DEAD);
+    Root = getEmpty(3);
+}
+
+void HashLife::setRule(RuleMasks rule) {
+    if (rule == Rule)
+        return;
+    Rule = rule;
+    for (Node& node : Nodes)
+        node.ResultLog = -1;
+}
+
+void HashLife::setMemoryBudget(size_t bytes) {
+    MaxNodes = bytes / sizeof(Node);
+    if (MaxNodes < 1024)
+        MaxNodes = 1024;
+}
+
+size_t HashLife::hashChildren(uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se) {
+    uint64_t hash = nw;
+    hash = hash * 0x9E3779B97F4A7C15ULL + ne;
+    hash = hash * 0x9E3779B97F4A7C15ULL + sw;
+    hash = hash * 0x9E3779B97F4A7C15ULL + se;
+    hash ^= hash >> 29;
+    hash *= 0xBF58476D1CE4E5B9ULL;
+    hash ^= hash >> 32;
+    return (size_t)hash;
+}
+
+void HashLife::rehash(size_t bucketCount) {
+    Buckets.assign(bucketCount, NONE);
+    for (uint32_t i = ALIVE + 1; i < Nodes.size(); i++) {
+        Node& node = Nodes[i];
+        if (node.Level == FREELEVEL)
+            continue;
+        size_t bucket = hashChildren(node.NW, node.NE, node.SW, node.SE) & (bucketCount - 1);
+        node.Next = Buckets[bucket];
+        Buckets[bucket] = i;
+    }
+}
+
+uint32_t HashLife::allocateNode() {
+    if (!FreeNodes.empty()) {
+        uint32_t index = FreeNodes.back();
+        FreeNodes.pop_back();
+        return index;
+    }
+    Nodes.push_back(Node());
+    return (uint32_t)(Nodes.size() - 1);
+}
+
+// Returns the canonical node with the given quadrants, creating it if needed.
+// Creating a node may reallocate the arena, so callers must not hold Node
+// references across this call.
+uint32_t HashLife::getNode(uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se) {
+    size_t bucket = hashChildren(nw, ne, sw, se) & (Buckets.size() - 1);
+    for (uint32_t i = Buckets[bucket]; i != NONE; i = Nodes[i].Next) {
+        const Node& node = Nodes[i];
+        if (node.NW == nw and node.NE == ne and node.SW == sw and node.SE == se)
+            return i;
+    }
+    uint32_t index = allocateNode();
+    Node& node = Nodes[index];
+    node.NW = nw;
+    node.NE = ne;
+    node.SW = sw;
+    node.SE = se;
+    node.Population = Nodes[nw].Population + Nodes[ne].Population + Nodes[sw].Population + Nodes[se].Population;
+    node.Level = Nodes[nw].Level + 1;
+    node.Result = NONE;
+    node.ResultLog = -1;
+    node.Marked = false;
+    node.Next = Buckets[bucket];
+    Buckets[bucket] = index;
+    if (++LiveNodes > NodeLimit)
+        Overflow = true;
+    if (LiveNodes > Buckets.size())
+        rehash(Buckets.size() * 2);
+    return index;
+}
+
+uint32_t HashLife::getEmpty(int level) {
+    while ((int)EmptyNodes.size() <= level) {
+        uint32_t empty = EmptyNodes.back();
+        EmptyNodes.push_back(getNode(empty, empty, empty, empty));
+    }
+    return EmptyNodes[level];
+}
+
+uint32_t HashLife::centre(uint32_t node) {
+    Node n = Nodes[node];
+    return getNode(Nodes[n.NW].SE, Nodes[n.NE].SW, Nodes[n.SW].NE, Nodes[n.SE].NW);
+}
+
+uint32_t HashLife::horizontal(uint32_t west, uint32_t east) {
+    Node w = Nodes[west], e = Nodes[east];
+    return getNode(w.NE, e.NW, w.SE, e.SW);
+}
+
+uint32_t HashLife::vertical(uint32_t north, uint32_t south) {
+    Node n = Nodes[north], s = Nodes[south];
+    return getNode(n.SW, n.SE, s.NW, s.NE);
+}
+
+// Centre 2x2 of a 4x4 node after one generation.
+uint32_t HashLife::stepBase(uint32_t node) {
+    bool cells[4][4];
+    Node n = Nodes[node];
+    uint32_t quadrants[4] = { n.NW, n.NE, n.SW, n.SE };
+    for (int q = 0; q < 4; q++) {
+        const Node& quadrant = Nodes[quadrants[q]];
+        int x = (q & 1) * 2, y = (q >> 1) * 2;
+        cells[y][x] = quadrant.NW == ALIVE;
+        cells[y][x + 1] = quadrant.NE == ALIVE;
+        cells[y + 1][x] = quadrant.SW == ALIVE;
+        cells[y + 1][x + 1] = quadrant.SE == ALIVE;
+    }
+    uint32_t next[4];
+    for (int i = 0; i < 4; i++) {
+        int x = 1 + (i & 1), y = 1 + (i >> 1);
+        int neighborSum = 0;
+        for (int dy = -1; dy <= 1; dy++)
+            for (int dx = -1; dx <= 1; dx++)
+                if (dx != 0 or dy != 0)
+                    neighborSum += cells[y + dy][x + dx];
+        uint16_t mask = cells[y][x] ? Rule.Survival : Rule.Birth;
+        next[i] = (mask >> neighborSum) & 1 ? ALIVE : DEAD;
+    }
+    return getNode(next[0], next[1], next[2], next[3]);
+}
+
+// Centre of the node (one level down) after 2^stepLog generations, where
+// stepLog <= level - 2. The node is split into nine overlapping subnodes; at
+// full speed both halves of the time step are spent recursively, otherwise the
+// first half is replaced by simply taking the centres. Once the arena passes
+// the node limit the recursion unwinds with NONE and stores no result.
+uint32_t HashLife::successor(uint32_t node, int stepLog) {
+    if (Overflow)
+        return NONE;
+    Node n = Nodes[node];
+    if (n.Population == 0)
+        return getEmpty(n.Level - 1);
+    if (n.ResultLog == stepLog)
+        return n.Result;
+
+    uint32_t result;
+    if (n.Level == 2)
+        result = stepBase(node);
+    else {
+        bool fullSpeed = stepLog == n.Level - 2;
+        uint32_t parts[9] = {
+            n.NW, horizontal(n.NW, n.NE), n.NE,
+            vertical(n.NW, n.SW), centre(node), vertical(n.NE, n.SE),
+            n.SW, horizontal(n.SW, n.SE), n.SE
+        };
+        for (uint32_t& part : parts)
+            part = fullSpeed ? successor(part, n.Level - 3) : centre(part);
+        if (Overflow)
+            return NONE;
+        int nextLog = fullSpeed ? n.Level - 3 : stepLog;
+        uint32_t nw = successor(getNode(parts[0], parts[1], parts[3], parts[4]), nextLog);
+        uint32_t ne = successor(getNode(parts[1], parts[2], parts[4], parts[5]), nextLog);
+        uint32_t sw = successor(getNode(parts[3], parts[4], parts[6], parts[7]), nextLog);
+        uint32_t se = successor(getNode(parts[4], parts[5], parts[7], parts[8]), nextLog);
+        if (Overflow)
+            return NONE;
+        result = getNode(nw, ne, sw, se);
+    }
+    Nodes[node].Result = result;
+    Nodes[node].ResultLog = (int8_t)stepLog;
+    return result;
+}
+
+// True when all live cells lie in the central half of the node.
+bool HashLife::isPadded(uint32_t node) const {
+    const Node& n = Nodes[node];
+    const Node& nw = Nodes[n.NW];
+    const Node& ne = Nodes[n.NE];
+    const Node& sw = Nodes[n.SW];
+    const Node& se = Nodes[n.SE];
+    return nw.Population == Nodes[nw.SE].Population and ne.Population == Nodes[ne.SW].Population and
+           sw.Population == Nodes[sw.NE].Population and se.Population == Nodes[se.NW].Population;
+}
+
+// Doubles the root around the same centre.
+void HashLife::expand() {
+    Node root = Nodes[Root];
+    uint32_t empty = getEmpty(root.Level - 1);
+    uint32_t nw = getNode(empty, empty, empty, root.NW);
+    uint32_t ne = getNode(empty, empty, root.NE, empty);
+    uint32_t sw = getNode(empty, root.SW, empty, empty);
+    uint32_t se = getNode(root.SE, empty, empty, empty);
+    Root = getNode(nw, ne, sw, se);
+    OriginX -= 1LL << (root.Level - 1);
+    OriginY -= 1LL << (root.Level - 1);
+}
+
+// Halves the root around the same centre while no live cell is lost. Since the
+// centre never moves, an unchanged pattern always ends up as the same root.
+void HashLife::trim() {
+    while (Nodes[Root].Level > 3 and isPadded(Root)) {
+        int level = Nodes[Root].Level;
+        Root = centre(Root);
+        OriginX += 1LL << (level - 2);
+        OriginY += 1LL << (level - 2);
+    }
+}
+
+uint32_t HashLife::build(const BitBoard& board, int level, int64_t x, int64_t y) {
+    if (x >= board.getWidth() or y >= board.getHeight())
+        return getEmpty(level);
+    if (level == 0)
+        return board.get((int)x, (int)y) ? ALIVE : DEAD;
+    int64_t half = 1LL << (level - 1);
+    uint32_t nw = build(board, level - 1, x, y);
+    uint32_t ne = build(board, level - 1, x + half, y);
+    uint32_t sw = build(board, level - 1, x, y + half);
+    uint32_t se = build(board, level - 1, x + half, y + half);
+    return getNode(nw, ne, sw, se);
+}
+
+void HashLife::load(const BitBoard& board, uint64_t generation) {
+    int level = 3;
+    while ((1LL << level) < board.getWidth() or (1LL << level) < board.getHeight())
+        level++;
+    Root = build(board, level, 0, 0);
+    OriginX = 0;
+    OriginY = 0;
+    Generation = generation;
+    trim();
+    if (LiveNodes > MaxNodes)
+        collectGarbage(true);
+}
+
+void HashLife::renderNode(uint32_t node, int64_t x, int64_t y, BitBoard& board) const {
+    const Node& n = Nodes[node];
+    int64_t size = 1LL << n.Level;
+    if (n.Population == 0 or x >= board.getWidth() or y >= board.getHeight() or x + size <= 0 or y + size <= 0)
+        return;
+    if (n.Level == 0) {
+        board.set((int)x, (int)y, true);
+        return;
+    }
+    int64_t half = size / 2;
+    renderNode(n.NW, x, y, board);
+    renderNode(n.NE, x + half, y, board);
+    renderNode(n.SW, x, y + half, board);
+    renderNode(n.SE, x + half, y + half, board);
+}
+
+void HashLife::render(BitBoard& board) const {
+    board.clear();
+    renderNode(Root, OriginX, OriginY, board);
+}
+
+// One jump of 2^stepLog generations. A jump that would grow the arena past the
+// budget is abandoned with the root untouched and false returned; single
+// generations are never abandoned, since they cannot be split any further.
+bool HashLife::advance(int stepLog) {
+    if (LiveNodes > MaxNodes) {
+        collectGarbage();
+        if (LiveNodes > MaxNodes / 2)
+            collectGarbage(true);
+    }
+
+    uint32_t previousRoot = Root;
+    int64_t previousX = OriginX, previousY = OriginY;
+    NodeLimit = stepLog > 0 ? MaxNodes : SIZE_MAX;
+    Overflow = false;
+    // Live cells move at most one cell per generation. Keeping the pattern in
+    // the central quarter of a root at least stepLog + 4 levels deep leaves
+    // enough empty border for it to stay inside the centre that successor() returns.
+    while (Nodes[Root].Level < stepLog + 3 or !isPadded(Root))
+        expand();
+    expand();
+    int level = Nodes[Root].Level;
+    uint32_t next = successor(Root, stepLog);
+    NodeLimit = SIZE_MAX;
+    if (Overflow) {
+        Overflow = false;
+        Root = previousRoot;
+        OriginX = previousX;
+        OriginY = previousY;
+        return false;
+    }
+    Root = next;
+    OriginX += 1LL << (level - 2);
+    OriginY += 1LL << (level - 2);
+    Generation += 1ULL << stepLog;
+    trim();
+    return true;
+}
+
+// Takes a jump that does not fit into the budget as two jumps of half the size,
+// with the garbage of the abandoned attempt collected in between.
+void HashLife::advanceWithinBudget(int stepLog) {
+    if (advance(stepLog))
+        return;
+    advanceWithinBudget(stepLog - 1);
+    advanceWithinBudget(stepLog - 1);
+}
+
+bool HashLife::step(int stepLog) {
+    if (stepLog < 0)
+        stepLog = 0;
+    if (stepLog > MAXLEVEL - 5)
+        stepLog = MAXLEVEL - 5;
+
+    uint32_t previousRoot = Root;
+    int64_t previousX = OriginX, previousY = OriginY;
+    advanceWithinBudget(stepLog);
+    return Root == previousRoot and OriginX == previousX and OriginY == previousY;
+}
+
+void HashLife::mark(uint32_t node, bool keepResults) {
+    if (node <= ALIVE or Nodes[node].Marked)
+        return;
+    Nodes[node].Marked = true;
+    Node n = Nodes[node];
+    mark(n.NW, keepResults);
+    mark(n.NE, keepResults);
+    mark(n.SW, keepResults);
+    mark(n.SE, keepResults);
+    if (keepResults and n.ResultLog >= 0)
+        mark(n.Result, keepResults);
+}
+
+void HashLife::collectGarbage(bool dropResults) {
+    mark(Root, !dropResults);
+    for (uint32_t empty : EmptyNodes)
+        mark(empty, !dropResults);
+    FreeNodes.clear();
+    LiveNodes = ALIVE + 1;
+    for (uint32_t i = ALIVE + 1; i < Nodes.size(); i++) {
+        Node& node = Nodes[i];
+        if (!node.Marked) {
+            node.Level = FREELEVEL;
+            FreeNodes.push_back(i);
+            continue;
+        }
+        node.Marked = false;
+        if (dropResults)
+            node.ResultLog = -1;
+        LiveNodes++;
+    }
+    rehash(Buckets.size());
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "BitBoard.h"
+#include "LifeKernel.h"
+
+// Hashlife engine. The universe is an unbounded plane stored as a quadtree of
+// canonical (hash-consed) nodes: a node of level L is a 2^L x 2^L square made of
+// four level L-1 quadrants, level 0 nodes are single cells. Every node caches
+// its population and the result of advancing its centre, so repeated structure
+// in space and time is computed once and the universe can jump 2^k generations
+// in a single step.
+//
+// Nodes live in an arena addressed by 32-bit indices. When the arena grows past
+// the memory budget, the nodes not reachable from the root are collected before
+// the next step; if that is not enough, the memoized results are dropped too.
+// A jump that would outgrow the budget on its own is abandoned midway and
+// retaken as two jumps of half the size.
+class HashLife {
+private:
+    struct Node {
+        uint32_t NW, NE, SW, SE;
+        uint32_t Next;       // next node in the same hash bucket
+        uint32_t Result;     // memoized centre after 2^ResultLog generations
+        uint64_t Population;
+        uint8_t Level;
+        int8_t ResultLog;    // -1 if Result is not valid
+        bool Marked;
+    };
+
+    static constexpr uint32_t NONE = 0;
+    static constexpr uint32_t DEAD = 1;
+    static constexpr uint32_t ALIVE = 2;
+    static constexpr int MAXLEVEL = 62;
+
+    std::vector<Node> Nodes;
+    std::vector<uint32_t> Buckets;
+    std::vector<uint32_t> FreeNodes;
+    std::vector<uint32_t> EmptyNodes;
+    size_t LiveNodes;
+    size_t MaxNodes;
+    size_t NodeLimit;    // LiveNodes past which the running jump is abandoned
+    bool Overflow;
+
+    uint32_t Root;
+    int64_t OriginX, OriginY; // universe coordinates of the root's top-left cell
+    RuleMasks Rule;
+    uint64_t Generation;
+
+    static size_t hashChildren(uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se);
+    void rehash(size_t bucketCount);
+    uint32_t allocateNode();
+    uint32_t getNode(uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se);
+    uint32_t getEmpty(int level);
+
+    uint32_t centre(uint32_t node);
+    uint32_t horizontal(uint32_t west, uint32_t east);
+    uint32_t vertical(uint32_t north, uint32_t south);
+    uint32_t stepBase(uint32_t node);
+    uint32_t successor(uint32_t node, int stepLog);
+    bool advance(int stepLog);
+    void advanceWithinBudget(int stepLog);
+
+    bool isPadded(uint32_t node) const;
+    void expand();
+    void trim();
+
+    uint32_t build(const BitBoard& board, int level, int64_t x, int64_t y);
+    void renderNode(uint32_t node, int64_t x, int64_t y, BitBoard& board) const;
+    void mark(uint32_t node, bool keepResults);
+
+public:
+    explicit HashLife(size_t memoryBudgetBytes = 256u << 20);
+
+    // Replaces the universe with the cells of the board, cell (x, y) of the
+    // board becoming cell (x, y) of the plane. The board does not wrap.
+    void load(const BitBoard& board, uint64_t generation = 0);
+
+    // Writes the part of the plane covered by the board into it.
+    void render(BitBoard& board) const;
+
+    // Advances the universe by 2^stepLog generations. Returns true when the
+    // pattern did not change (still life or empty universe).
+    bool step(int stepLog);
+
+    uint64_t getGeneration() const { return Generation; }
+
+    uint64_t getPopulation() const { return Nodes[Root].Population; }
+
+    size_t getNodeCount() const { return LiveNodes; }
+
+    size_t getMemoryUsage() const { return Nodes.capacity() * sizeof(Node) + Buckets.capacity() * sizeof(uint32_t); }
+
+    void setMemoryBudget(size_t bytes);
+
+    // Any Life-like rule without B0. Changing it drops the memoized results.
+    void setRule(RuleMasks rule);
+
+    // Frees the nodes that are not reachable from the root. Memoized results
+    // are kept alive unless dropResults is set.
+    void collectGarbage(bool dropResults = false);
+};
@@ -0,0 +1,361 @@
+#include "Headless.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include "GameOfLife.h"
+#include "PatternIO.h"
+#include "Checkpoint.h"
+#include "SoupSearch.h"
+#include "FastRandom.h"
+
+// Exported animations are at most this many pixels on a side unless
+// --export-scale says otherwise; small boards are enlarged to at least the minimum.
+static constexpr int EXPORTMINSIDE = 256, EXPORTMAXSIDE = 1024;
+
+struct HeadlessOptions {
+    long long Generations = 1000;
+    std::string Input, Output, Checkpoint, Trace, SoupLog, Export;
+    long long CheckpointEvery = 0;
+    long long TraceEvery = 1;
+    long long ExportEvery = 1;
+    int ExportScale = 0; // cells per pixel, 0 for a size of at most EXPORTMAXSIDE pixels
+    int ExportDelay = 100;
+    bool ExportWait = false;
+    bool Census = false;
+    int Width = 0, Height = 0;
+    unsigned Seed = 0;
+    bool HasSeed = false;
+    int Threads = (int)std::thread::hardware_concurrency();
+    KernelKind Kernel = detectBestKernel();
+    BoundaryKind Boundary = BoundaryKind::Torus;
+    int HashLifeStep = -1;
+    bool Unbounded = false;
+    int Processes = 1;
+    LifeRule Rule;
+    bool HasRule = false;
+    long long Soups = 0;
+    int SoupSize = 16;
+};
+
+static bool parseNumber(const char* text, long long minimum, long long maximum, long long& value) {
+    char* end;
+    value = std::strtoll(text, &end, 10);
+    return *text != '\0' and *end == '\0' and value >= minimum and value <= maximum;
+}
+
+static bool parseOptions(int argc, char** argv, HeadlessOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string option = argv[i];
+        if (option == "--headless")
+            continue;
+        if (option == "--unbounded") {
+            options.Unbounded = true;
+            continue;
+        }
+        if (option == "--export-wait") {
+            options.ExportWait = true;
+            continue;
+        }
+        if (option == "--census") {
+            options.Census = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::fprintf(stderr, "Missing value for %s\n", option.c_str());
+            return false;
+        }
+        const char* value = argv[++i];
+        long long number = 0;
+        bool valid = true;
+        if (option == "--generations")
+            valid = parseNumber(value, 0, 1LL << 62, number) and (options.Generations = number, true);
+        else if (option == "--input")
+            options.Input = value;
+        else if (option == "--output")
+            options.Output = value;
+        else if (option == "--checkpoint")
+            options.Checkpoint = value;
+        else if (option == "--checkpoint-every")
+            valid = parseNumber(value, 1, 1LL << 62, number) and (options.CheckpointEvery = number, true);
+        else if (option == "--trace")
+            options.Trace = value;
+        else if (option == "--trace-every")
+            valid = parseNumber(value, 1, 1LL << 62, number) and (options.TraceEvery = number, true);
+        else if (option == "--export")
+            options.Export = value;
+        else if (option == "--export-every")
+            valid = parseNumber(value, 1, 1LL << 62, number) and (options.ExportEvery = number, true);
+        else if (option == "--export-scale")
+            valid = parseNumber(value, 1, 1 << 20, number) and (options.ExportScale = (int)number, true);
+        else if (option == "--export-delay")
+            valid = parseNumber(value, 0, 65535, number) and (options.ExportDelay = (int)number, true);
+        else if (option == "--soups")
+            valid = parseNumber(value, 1, 1LL << 62, number) and (options.Soups = number, true);
+        else if (option == "--soup-size")
+            valid = parseNumber(value, 1, 1 << 16, number) and (options.SoupSize = (int)number, true);
+        else if (option == "--soup-log")
+            options.SoupLog = value;
+        else if (option == "--width")
+            valid = parseNumber(value, 1, 1 << 20, number) and (options.Width = (int)number, true);
+        else if (option == "--height")
+            valid = parseNumber(value, 1, 1 << 20, number) and (options.Height = (int)number, true);
+        else if (option == "--seed")
+            valid = parseNumber(value, 0, 0xFFFFFFFFLL, number) and (options.Seed = (unsigned)number, options.HasSeed = true);
+        else if (option == "--threads")
+            valid = parseNumber(value, 1, 1024, number) and (options.Threads = (int)number, true);
+        else if (option == "--kernel")
+            valid = parseKernelName(value, options.Kernel) and isKernelSupported(options.Kernel);
+        else if (option == "--boundary")
+            valid = parseBoundaryName(value, options.Boundary);
+        else if (option == "--rule")
+            valid = parseRule(value, options.Rule) and (options.HasRule = true);
+        else if (option == "--processes")
+            valid = parseNumber(value, 1, 1024, number) and (options.Processes = (int)number, true);
+        else if (option == "--hashlife")
+            valid = parseNumber(value, -1, 56, number) and (options.HashLifeStep = (int)number, true);
+        else {
+            std::fprintf(stderr, "Unknown option %s\n", option.c_str());
+            return false;
+        }
+        if (!valid) {
+            std::fprintf(stderr, "Invalid value for %s: %s\n", option.c_str(), value);
+            return false;
+        }
+    }
+    if (options.Input.empty() and options.Soups == 0 and (options.Width == 0 or options.Height == 0)) {
+        std::fprintf(stderr, "Either --input or both --width and --height are required\n");
+        return false;
+    }
+    return true;
+}
+
+// The pattern goes to the top-left corner of a board of the requested size,
+// or fills the board exactly when no size was given. rule is the one the file
+// names, empty if it names none.
+static bool loadBoard(const HeadlessOptions& options, BitBoard& board, long long& generation, std::string& rule, std::vector<uint8_t>& states) {
+    generation = 0;
+    rule.clear();
+    states.clear();
+    if (!options.Input.empty()) {
+        BitBoard pattern;
+        CheckpointInfo info;
+        if (isCheckpointFile(options.Input)) {
+            if (!readCheckpoint(options.Input, pattern, info)) {
+                std::fprintf(stderr, "Cannot read checkpoint %s\n", options.Input.c_str());
+                return false;
+            }
+            generation = info.Generation;
+            rule = info.Rule;
+            states.swap(info.States);
+        }
+        else if (!readPattern(options.Input, pattern, &rule)) {
+            std::fprintf(stderr, "Cannot read pattern %s\n", options.Input.c_str());
+            return false;
+        }
+        int height = options.Height > 0 ? options.Height : pattern.getHeight();
+        int width = options.Width > 0 ? options.Width : pattern.getWidth();
+        pattern.resize(height, width);
+        board.swap(pattern);
+        return true;
+    }
+    FastRandom random(options.HasSeed ? options.Seed : std::random_device()());
+    board = BitBoard(options.Height, options.Width);
+    fillRandom(board, random);
+    return true;
+}
+
+// Soups are run in batches, so the log is written in seed order while the
+// lanes finish soups in any order.
+static int runSoupSearch(const HeadlessOptions& options) {
+    static constexpr int BATCH = 4096;
+    int height = options.Height > 0 ? options.Height : 128;
+    int width = options.Width > 0 ? options.Width : 128;
+    uint64_t firstSeed = options.HasSeed ? options.Seed : std::random_device()();
+    FILE* log = stdout;
+    if (!options.SoupLog.empty() and !(log = std::fopen(options.SoupLog.c_str(), "w"))) {
+        std::fprintf(stderr, "Cannot write %s\n", options.SoupLog.c_str());
+        return 1;
+    }
+
+    SoupSearch search(height, width, options.SoupSize, options.Threads);
+    search.setRule(options.Rule);
+    search.setKernel(options.Kernel);
+    search.setMaxGenerations(options.Generations);
+    std::vector<SoupResult> results;
+    SoupResult longest = { firstSeed, -1, 0, 0 };
+    long long settled = 0;
+    std::fprintf(log, "seed,generations,period,population\n");
+    auto start = std::chrono::steady_clock::now();
+    for (long long done = 0; done < options.Soups; done += BATCH) {
+        search.run(firstSeed + (uint64_t)done, (int)std::min<long long>(BATCH, options.Soups - done), results);
+        for (const SoupResult& result : results) {
+            std::fprintf(log, "%llu,%lld,%lld,%lld\n", (unsigned long long)result.Seed, result.Generations, result.Period, result.Population);
+            settled += result.Period > 0;
+            if (result.Period > 0 and result.Generations > longest.Generations)
+                longest = result;
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (log != stdout and std::fclose(log) != 0) {
+        std::fprintf(stderr, "Cannot write %s\n", options.SoupLog.c_str());
+        return 1;
+    }
+
+    // The longest-lived soup that settled, as it was at generation 0.
+    if (!options.Output.empty() and longest.Generations >= 0) {
+        BitBoard soup(height, width);
+        fillSoup(soup, longest.Seed, options.SoupSize);
+        if (!writePattern(options.Output, soup, formatRule(options.Rule))) {
+            std::fprintf(stderr, "Cannot write %s\n", options.Output.c_str());
+            return 1;
+        }
+    }
+    FILE* summary = log == stdout ? stderr : stdout;
+    std::fprintf(summary, "Soups: %lld of %d x %d on %d x %d, %d threads\n", options.Soups, options.SoupSize, options.SoupSize, width, height, search.getThreadCount());
+    std::fprintf(summary, "Rule: %s\n", formatRule(options.Rule).c_str());
+    std::fprintf(summary, "Settled: %lld within %lld generations\n", settled, options.Generations);
+    if (longest.Generations >= 0)
+        std::fprintf(summary, "Longest: seed %llu, %lld generations, period %lld, population %lld\n", (unsigned long long)longest.Seed, longest.Generations, longest.Period, longest.Population);
+    ObjectCensus census;
+    search.getCensus(census);
+    std::fprintf(summary, "Census: %s\n", census.format().c_str());
+    std::fprintf(summary, "Time: %.3f sec\n", seconds);
+    std::fprintf(summary, "Soups per second: %.1f\n", seconds > 0 ? options.Soups / seconds : 0.0);
+    return 0;
+}
+
+bool isHeadlessRequested(int argc, char** argv) {
+    for (int i = 1; i < argc; i++)
+        if (std::strcmp(argv[i], "--headless") == 0)
+            return true;
+    return false;
+}
+
+int runHeadless(int argc, char** argv) {
+    HeadlessOptions options;
+    if (!parseOptions(argc, argv, options))
+        return 1;
+    if (options.Soups > 0)
+        return runSoupSearch(options);
+    BitBoard board;
+    long long generation;
+    std::string fileRule;
+    std::vector<uint8_t> states;
+    if (!loadBoard(options, board, generation, fileRule, states))
+        return 1;
+    // --rule overrides the rule of the file.
+    LifeRule rule = options.Rule;
+    if (!options.HasRule and !fileRule.empty() and !parseRule(fileRule, rule)) {
+        std::fprintf(stderr, "Unsupported rule %s in %s\n", fileRule.c_str(), options.Input.c_str());
+        return 1;
+    }
+
+    GameOfLife life(board.getHeight(), board.getWidth());
+    life.setBoard(board);
+    life.setGeneration(generation);
+    life.setRule(rule);
+    life.setKernel(options.Kernel);
+    life.setBoundary(options.Boundary);
+    life.setThreadCount(options.Threads);
+    life.setHashLifeStep(options.HashLifeStep);
+    life.setUnbounded(options.Unbounded);
+    life.setProcessCount(options.Processes);
+    // Dying cells of a checkpoint, unless the board was resized or the rule replaced.
+    if (!states.empty() and !life.setCellStates(states))
+        std::fprintf(stderr, "Dying cells of %s dropped: the board size or the rule differs\n", options.Input.c_str());
+
+    // Without --trace nothing is attached and iterate() measures nothing.
+    Instrumentation stats;
+    if (!options.Trace.empty()) {
+        stats.setTraceInterval(options.TraceEvery);
+        life.setInstrumentation(&stats);
+    }
+
+    // Frames are encoded on the writer's thread; unless --export-wait, those
+    // that find its queue full are dropped rather than slowing the run down.
+    AnimationWriter animation;
+    if (!options.Export.empty()) {
+        int cellsPerPixel = options.ExportScale, pixelsPerCell = 1;
+        if (cellsPerPixel == 0)
+            chooseAnimationScale(life.getWidth(), life.getHeight(), EXPORTMINSIDE, EXPORTMAXSIDE, cellsPerPixel, pixelsPerCell);
+        if (!animation.open(options.Export, life.getWidth(), life.getHeight(), cellsPerPixel, pixelsPerCell, options.ExportDelay)) {
+            std::fprintf(stderr, "Cannot write %s\n", options.Export.c_str());
+            return 1;
+        }
+        animation.setBlocking(options.ExportWait);
+        life.setRecorder(&animation, options.ExportEvery);
+    }
+
+    CheckpointWriter checkpoints;
+    long long nextCheckpoint = generation + options.CheckpointEvery;
+    bool isStable = false;
+    auto start = std::chrono::steady_clock::now();
+    while (life.getGeneration() < options.Generations) {
+        isStable = life.iterate();
+        // While the previous checkpoint is still being written, save() refuses and is retried next generation.
+        if (!options.Checkpoint.empty() and options.CheckpointEvery > 0 and life.getGeneration() >= nextCheckpoint and
+            checkpoints.save(options.Checkpoint, life.getBoard(), { life.getGeneration(), life.getPopulation(), life.getRuleName(), life.getCellStates() }))
+            nextCheckpoint = life.getGeneration() + options.CheckpointEvery;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    generation = life.getGeneration() - generation;
+
+    if (!options.Checkpoint.empty()) {
+        checkpoints.wait();
+        if (!checkpoints.save(options.Checkpoint, life.getBoard(), { life.getGeneration(), life.getPopulation(), life.getRuleName(), life.getCellStates() }) or !checkpoints.wait()) {
+            std::fprintf(stderr, "Cannot write checkpoint %s\n", options.Checkpoint.c_str());
+            return 1;
+        }
+    }
+    if (!options.Export.empty()) {
+        life.setRecorder(nullptr, 1);
+        animation.finish();
+        if (!animation.wait()) {
+            std::fprintf(stderr, "Cannot write %s\n", options.Export.c_str());
+            return 1;
+        }
+    }
+    if (!options.Trace.empty() and !stats.writeTrace(options.Trace)) {
+        std::fprintf(stderr, "Cannot write trace %s\n", options.Trace.c_str());
+        return 1;
+    }
+    if (!options.Output.empty() and !writePattern(options.Output, life.getBoard(), life.getRuleName())) {
+        std::fprintf(stderr, "Cannot write %s\n", options.Output.c_str());
+        return 1;
+    }
+    std::printf("Board: %d x %d\n", life.getWidth(), life.getHeight());
+    std::printf("Rule: %s\n", life.getRuleName().c_str());
+    if (life.getHashLifeStep() < 0 and !life.isUnbounded())
+        std::printf("Boundary: %s\n", getBoundaryName(life.getRule().isLifeLike() ? life.getBoundary() : BoundaryKind::Torus));
+    if (!life.getRule().isLifeLike())
+        std::printf("Kernel: cell states, %d threads\n", life.getThreadCount());
+    else if (life.getHashLifeStep() >= 0)
+        std::printf("Kernel: HashLife 2^%d\n", life.getHashLifeStep());
+    else if (life.isUnbounded())
+        std::printf("Kernel: unbounded, %zu chunks\n", life.getChunkCount());
+    else if (life.getClusterProcesses() > 0)
+        std::printf("Kernel: %s, %d processes on %d NUMA nodes\n", getKernelName(life.getActiveKernel()), life.getClusterProcesses(), life.getClusterNodes());
+    else
+        std::printf("Kernel: %s, %d threads\n", getKernelName(life.getActiveKernel()), life.getThreadCount());
+    std::printf("Generation: %lld\n", life.getGeneration());
+    std::printf("Time: %.3f sec\n", seconds);
+    std::printf("Generations per second: %.1f\n", seconds > 0 ? generation / seconds : 0.0);
+    std::printf("Population: %lld\n", life.getPopulation());
+    if (!options.Trace.empty()) {
+        std::printf("Step: %.1f us per call, stable check: %.1f us\n", stats.getAverageMicros(Phase::Step), stats.getAverageMicros(Phase::StableCheck));
+        if (stats.getAllocations() >= 0)
+            std::printf("Allocations: %lld\n", stats.getAllocations());
+    }
+    if (!options.Export.empty())
+        std::printf("Export: %lld frames, %lld dropped\n", animation.getFramesWritten(), animation.getFramesDropped());
+    if (isStable or life.getPeriod() > 0 or options.Census) {
+        ObjectCensus census;
+        life.takeCensus(census);
+        std::printf("Census: %s\n", census.format().c_str());
+    }
+    return 0;
+}
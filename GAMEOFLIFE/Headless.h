@@ -0,0 +1,52 @@
+#pragma once
+
+// Batch mode for machines without a terminal: runs the simulation at full
+// speed, with no rendering and no frame pacing, then reports the speed and the
+// final population.
+//
+//   GAMEOFLIFE --headless --generations N [--input pattern] [--output file]
+//              [--width W --height H] [--seed S] [--threads T]
+//              [--kernel scalar|sse2|avx2|avx-512] [--hashlife k] [--unbounded]
+//              [--processes P] [--rule B3/S23] [--boundary torus|dead|klein|cylinder]
+//              [--checkpoint file [--checkpoint-every N]]
+//              [--trace file.csv|file.json [--trace-every N]]
+//              [--export file.gif|file.png|file [--export-every N]
+//               [--export-scale S] [--export-delay ms] [--export-wait]]
+//              [--census]
+//
+// Pattern files are RLE, Life 1.06 or plaintext, chosen by extension (see
+// PatternIO.h); --generations 0 converts between them. Without --input the
+// board is a random soup of --width x --height cells. With --unbounded the
+// pattern evolves on an infinite plane and the board is the window written to
+// --output. With --processes the board is split into P strips stepped by as
+// many worker processes (Linux only, see StripCluster.h), instead of threads.
+// --boundary chooses what lies beyond the edges of the board (see
+// BoundaryKind in LifeKernel.h), the torus by default.
+// An --input checkpoint (see Checkpoint.h) resumes the run at its
+// generation; --generations is the generation to stop at, not a count.
+// --checkpoint writes one at the end and, with --checkpoint-every, in the
+// background during the run. The rule comes from --rule, else from the RLE
+// header or the checkpoint, else it is B3/S23 (see LifeRule.h). --trace writes
+// the step and stable-check times, population and allocations every
+// --trace-every generations (see Instrumentation.h). --export records every
+// --export-every-th generation as an animated GIF, an APNG or a raw frame
+// stream (see AnimationExport.h), S cells to a pixel: by default the board is
+// shrunk by a power of two to at most 1024 pixels or enlarged to at least 256.
+// Each frame shows for --export-delay milliseconds (100). Frames the encoder
+// cannot keep up with are dropped, unless --export-wait makes the run wait for it.
+// A board that settled gets a census of its objects (see ObjectCensus.h), as
+// does any final board with --census.
+//
+//   GAMEOFLIFE --headless --soups N [--soup-size S] [--soup-log file.csv]
+//              [--width W --height H] [--seed first] [--generations limit]
+//              [--threads T] [--rule B3/S23] [--output longest.rle]
+//
+// Soup search runs N random S x S soups (16 x 16 by default) on boards of
+// W x H (128 x 128), seeds first ... first + N - 1, across the threads. Each
+// runs until it settles or reaches --generations; its seed, generations to
+// settle, period and final population are logged as CSV, to stdout unless
+// --soup-log is given. --output gets the longest-lived settled soup. The
+// summary ends with the census of all the settled soups.
+bool isHeadlessRequested(int argc, char** argv);
+
+int runHeadless(int argc, char** argv);
@@ -0,0 +1,6 @@
+#include "Headless.h"
+
+// Entry point of the headless build, which does not link curses.
+int main(int argc, char** argv) {
+    return runHeadless(argc, argv);
+}
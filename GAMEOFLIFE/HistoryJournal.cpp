@@ -0,0 +1,180 @@
+#include "HistoryJournal.h"
+#include <algorithm>
+#include <cstring>
+
+constexpr size_t HistoryJournal::MINSEGMENTBYTES;
+
+void HistoryJournal::setBudget(size_t bytes) {
+    Budget = bytes;
+    if (Budget == 0)
+        clear();
+    else
+        trim();
+}
+
+void HistoryJournal::clear() {
+    Segments.clear();
+    Used = 0;
+}
+
+long long HistoryJournal::getNextGeneration(long long generation) const {
+    for (const Segment& segment : Segments)
+        for (const Record& record : segment.Records)
+            if (record.Generation > generation)
+                return record.Generation;
+    return -1;
+}
+
+// The gap to the previous word index as a little-endian base-128 varint,
+// then the word itself.
+void HistoryJournal::putWord(Segment& segment, size_t index, size_t& previous, uint64_t word) {
+    size_t gap = index - previous;
+    previous = index;
+    while (gap >= 0x80) {
+        segment.Data.push_back((uint8_t)(gap | 0x80));
+        gap >>= 7;
+    }
+    segment.Data.push_back((uint8_t)gap);
+    uint8_t bytes[8];
+    std::memcpy(bytes, &word, 8);
+    segment.Data.insert(segment.Data.end(), bytes, bytes + 8);
+}
+
+void HistoryJournal::beginRecord(Segment& segment, long long generation) {
+    segment.Records.push_back({ generation, segment.Data.size() });
+}
+
+void HistoryJournal::endRecord(Segment& segment, size_t usageBefore) {
+    Used += getSegmentUsage(segment) - usageBefore;
+    trim();
+}
+
+// The newest segment always stays, even when it alone is over budget.
+void HistoryJournal::trim() {
+    while (Used > Budget and Segments.size() > 1) {
+        Used -= getSegmentUsage(Segments.front());
+        Segments.pop_front();
+    }
+}
+
+void HistoryJournal::addKeyframe(const BitBoard& board, long long generation) {
+    truncateAfter(generation - 1);
+    if (board.getWidth() != Width or board.getHeight() != Height) {
+        clear();
+        Width = board.getWidth();
+        Height = board.getHeight();
+    }
+    // The segment before is complete; its spare capacity goes back.
+    if (!Segments.empty()) {
+        Segment& last = Segments.back();
+        size_t usageBefore = getSegmentUsage(last);
+        last.Data.shrink_to_fit();
+        last.Records.shrink_to_fit();
+        Used -= usageBefore - getSegmentUsage(last);
+    }
+    Segments.emplace_back();
+    Segment& segment = Segments.back();
+    beginRecord(segment, generation);
+    int wordsPerRow = board.getWordsPerRow();
+    size_t previous = 0;
+    for (int y = 0; y < board.getHeight(); y++) {
+        const uint64_t* words = board.row(y);
+        for (int x = 0; x < wordsPerRow; x++)
+            if (words[x])
+                putWord(segment, (size_t)y * wordsPerRow + x, previous, words[x]);
+    }
+    segment.KeyframeBytes = segment.Data.size();
+    endRecord(segment, 0);
+}
+
+void HistoryJournal::addStep(const BitBoard& before, const BitBoard& after, long long generation,
+                             const uint8_t* changedTiles, int tilesX, int tileRows) {
+    if (Segments.empty() or after.getWidth() != Width or after.getHeight() != Height) {
+        addKeyframe(after, generation);
+        return;
+    }
+    Segment* segment = &Segments.back();
+    if (segment->Data.size() - segment->KeyframeBytes >= std::max(segment->KeyframeBytes, MINSEGMENTBYTES)) {
+        addKeyframe(after, generation);
+        return;
+    }
+    size_t usageBefore = getSegmentUsage(*segment);
+    beginRecord(*segment, generation);
+    int wordsPerRow = after.getWordsPerRow();
+    size_t previous = 0;
+    for (int y = 0; y < Height; y++) {
+        const uint64_t* oldRow = before.row(y);
+        const uint64_t* newRow = after.row(y);
+        const uint8_t* changed = changedTiles ? changedTiles + (size_t)(y / tileRows) * tilesX : nullptr;
+        for (int x = 0; x < wordsPerRow; x++) {
+            if (changed and !changed[x])
+                continue;
+            uint64_t flips = oldRow[x] ^ newRow[x];
+            if (flips)
+                putWord(*segment, (size_t)y * wordsPerRow + x, previous, flips);
+        }
+    }
+    endRecord(*segment, usageBefore);
+}
+
+void HistoryJournal::truncateAfter(long long generation) {
+    while (!Segments.empty()) {
+        Segment& segment = Segments.back();
+        size_t usageBefore = getSegmentUsage(segment);
+        if (segment.Records.front().Generation > generation) {
+            Used -= usageBefore;
+            Segments.pop_back();
+            continue;
+        }
+        size_t keep = segment.Records.size();
+        while (segment.Records[keep - 1].Generation > generation)
+            keep--;
+        if (keep < segment.Records.size()) {
+            segment.Data.resize(segment.Records[keep].Offset);
+            segment.Records.resize(keep);
+            Used += getSegmentUsage(segment) - usageBefore;
+        }
+        break;
+    }
+}
+
+void HistoryJournal::applyRecord(const Segment& segment, size_t record, BitBoard& board) {
+    const uint8_t* data = segment.Data.data() + segment.Records[record].Offset;
+    const uint8_t* end = segment.Data.data() + (record + 1 < segment.Records.size() ? segment.Records[record + 1].Offset : segment.Data.size());
+    // Word indices run over the rows without their ghost words.
+    size_t wordsPerRow = (size_t)board.getWordsPerRow();
+    size_t y = 0, x = 0;
+    while (data < end) {
+        size_t gap = 0;
+        int shift = 0;
+        while (*data & 0x80) {
+            gap |= (size_t)(*data++ & 0x7F) << shift;
+            shift += 7;
+        }
+        gap |= (size_t)*data++ << shift;
+        x += gap;
+        if (x >= wordsPerRow) {
+            y += x / wordsPerRow;
+            x %= wordsPerRow;
+        }
+        uint64_t word;
+        std::memcpy(&word, data, 8);
+        data += 8;
+        board.row((int)y)[x] ^= word;
+    }
+}
+
+long long HistoryJournal::seek(long long generation, BitBoard& board) const {
+    for (auto segment = Segments.rbegin(); segment != Segments.rend(); ++segment) {
+        if (segment->Records.front().Generation > generation)
+            continue;
+        if (board.getWidth() != Width or board.getHeight() != Height)
+            board.resize(Height, Width);
+        board.clear();
+        size_t record = 0;
+        for (; record < segment->Records.size() and segment->Records[record].Generation <= generation; record++)
+            applyRecord(*segment, record, board);
+        return segment->Records[record - 1].Generation;
+    }
+    return -1;
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <deque>
+#include <vector>
+#include "BitBoard.h"
+
+// Past generations of one board within a memory budget. The history is a
+// chain of segments; a segment starts with a keyframe and continues with one
+// delta per recorded generation. Both are stored the same way, as the board
+// words that differ from the previous record (from an empty board for the
+// keyframe): a varint gap to the word index, then the XOR word. A sparse board
+// thus makes a small keyframe, and a generation costs about 9 bytes per word
+// that changed. A new segment starts once the deltas of the current one
+// outgrow its keyframe, so seeking replays at most about two keyframes worth
+// of data. Over budget, the oldest segments are dropped.
+class HistoryJournal {
+private:
+    // Deltas of a segment may reach this size even after a tiny keyframe.
+    static constexpr size_t MINSEGMENTBYTES = 4096;
+
+    struct Record {
+        long long Generation;
+        size_t Offset; // into Data; the record ends where the next one starts
+    };
+
+    struct Segment {
+        std::vector<Record> Records;
+        std::vector<uint8_t> Data;
+        size_t KeyframeBytes;
+    };
+
+    std::deque<Segment> Segments;
+    size_t Budget, Used;
+    int Width, Height;
+
+    static size_t getSegmentUsage(const Segment& segment) {
+        return segment.Data.capacity() + segment.Records.capacity() * sizeof(Record);
+    }
+
+    void putWord(Segment& segment, size_t index, size_t& previous, uint64_t word);
+    void beginRecord(Segment& segment, long long generation);
+    void endRecord(Segment& segment, size_t usageBefore);
+    void trim();
+    static void applyRecord(const Segment& segment, size_t record, BitBoard& board);
+
+public:
+    explicit HistoryJournal(size_t budget = 0) : Budget(budget), Used(0), Width(0), Height(0) {}
+
+    // Bytes the history may take, 0 - no history.
+    void setBudget(size_t bytes);
+
+    size_t getBudget() const { return Budget; }
+
+    bool isEnabled() const { return Budget > 0; }
+
+    bool isEmpty() const { return Segments.empty(); }
+
+    void clear();
+
+    // -1 when empty.
+    long long getFirstGeneration() const { return Segments.empty() ? -1 : Segments.front().Records.front().Generation; }
+
+    long long getLastGeneration() const { return Segments.empty() ? -1 : Segments.back().Records.back().Generation; }
+
+    // The first recorded generation after the given one, -1 if there is none.
+    long long getNextGeneration(long long generation) const;
+
+    // Starts a new segment with the board, dropping the records from generation on.
+    void addKeyframe(const BitBoard& board, long long generation);
+
+    // Records after, the board of the given generation, as a delta to before,
+    // which must be the board of the last record. With changedTiles (tilesX
+    // tiles of tileRows rows by one word per row of tiles) only the words of
+    // changed tiles are compared; the others must be equal.
+    void addStep(const BitBoard& before, const BitBoard& after, long long generation,
+                 const uint8_t* changedTiles = nullptr, int tilesX = 0, int tileRows = 0);
+
+    // Drops the records after generation.
+    void truncateAfter(long long generation);
+
+    // Rebuilds the latest recorded board at or before generation into board
+    // and returns its generation, or -1 when the history starts later.
+    long long seek(long long generation, BitBoard& board) const;
+
+    size_t getMemoryUsage() const { return Used; }
+};
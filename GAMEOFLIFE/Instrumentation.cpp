@@ -0,0 +1,188 @@
+#include "Instrumentation.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+constexpr int Instrumentation::POPULATIONSAMPLES;
+constexpr double Instrumentation::RATEWINDOW;
+
+static thread_local bool ISCOUNTED = false;
+
+#ifdef LIFE_COUNT_ALLOCATIONS
+
+// The other forms of new and delete fall back to these. Threads outside a
+// CountedAllocations scope only pay for reading a thread-local flag.
+static std::atomic<long long> ALLOCATIONS(0);
+
+void* operator new(std::size_t size) {
+    if (ISCOUNTED)
+        ALLOCATIONS.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size == 0 ? 1 : size))
+        return memory;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+long long getAllocationCount() {
+    return ALLOCATIONS.load(std::memory_order_relaxed);
+}
+
+#else
+
+long long getAllocationCount() {
+    return -1;
+}
+
+#endif
+
+CountedAllocations::CountedAllocations() : WasCounted(ISCOUNTED) {
+    ISCOUNTED = true;
+}
+
+CountedAllocations::~CountedAllocations() {
+    ISCOUNTED = WasCounted;
+}
+
+const char* getPhaseName(Phase phase) {
+    static const char* const names[PHASECOUNT] = { "step", "stable_check", "render", "input" };
+    return names[(int)phase];
+}
+
+Instrumentation::Instrumentation() : PopulationSeries(POPULATIONSAMPLES), TraceInterval(0) {
+    restart();
+}
+
+void Instrumentation::restart() {
+    for (PhaseStats& stats : Phases)
+        stats = PhaseStats{ Clock::duration::zero(), Clock::duration::zero(), Clock::duration::zero(), 0 };
+    Start = WindowStart = Clock::now();
+    Generations = 0;
+    StartAllocations = getAllocationCount();
+    WindowGenerations = 0;
+    WindowCells = 0;
+    GenerationRate = CellRate = 0;
+    SeriesNext = SeriesSize = 0;
+    NextSample = 0;
+    Trace.clear();
+}
+
+void Instrumentation::recordGenerations(long long generation, long long advanced, long long population, double cellsPerGeneration) {
+    Generations += advanced;
+    WindowGenerations += advanced;
+    WindowCells += cellsPerGeneration * advanced;
+    Clock::time_point now = Clock::now();
+    double window = std::chrono::duration<double>(now - WindowStart).count();
+    if (window >= RATEWINDOW) {
+        GenerationRate = WindowGenerations / window;
+        CellRate = WindowCells / window;
+        WindowStart = now;
+        WindowGenerations = 0;
+        WindowCells = 0;
+    }
+    PopulationSeries[SeriesNext] = population;
+    SeriesNext = (SeriesNext + 1) % POPULATIONSAMPLES;
+    SeriesSize = std::min(SeriesSize + 1, POPULATIONSAMPLES);
+    if (TraceInterval > 0 and generation >= NextSample) {
+        addSample(generation, population);
+        NextSample = generation - generation % TraceInterval + TraceInterval;
+    }
+}
+
+void Instrumentation::addSample(long long generation, long long population) {
+    TraceSample sample;
+    sample.Generation = generation;
+    sample.Population = population;
+    sample.Allocations = getAllocations();
+    sample.Seconds = getSeconds();
+    for (int i = 0; i < PHASECOUNT; i++) {
+        sample.PhaseSeconds[i] = std::chrono::duration<double>(Phases[i].SinceSample).count();
+        Phases[i].SinceSample = Clock::duration::zero();
+    }
+    Trace.push_back(sample);
+}
+
+double Instrumentation::getLastMicros(Phase phase) const {
+    return std::chrono::duration<double, std::micro>(Phases[(int)phase].Last).count();
+}
+
+double Instrumentation::getAverageMicros(Phase phase) const {
+    const PhaseStats& stats = Phases[(int)phase];
+    return stats.Count > 0 ? std::chrono::duration<double, std::micro>(stats.Total).count() / stats.Count : 0.0;
+}
+
+// A window that has not been closed for a while means the run has stopped.
+double Instrumentation::getGenerationRate() const {
+    return std::chrono::duration<double>(Clock::now() - WindowStart).count() < 2 * RATEWINDOW ? GenerationRate : 0.0;
+}
+
+double Instrumentation::getCellRate() const {
+    return std::chrono::duration<double>(Clock::now() - WindowStart).count() < 2 * RATEWINDOW ? CellRate : 0.0;
+}
+
+long long Instrumentation::getAllocations() const {
+    if (StartAllocations < 0)
+        return -1;
+    return getAllocationCount() - StartAllocations;
+}
+
+std::vector<long long> Instrumentation::getPopulationSeries(int count) const {
+    count = std::min(count, SeriesSize);
+    std::vector<long long> series(count);
+    for (int i = 0; i < count; i++)
+        series[i] = PopulationSeries[(SeriesNext - count + i + POPULATIONSAMPLES) % POPULATIONSAMPLES];
+    return series;
+}
+
+void Instrumentation::setTraceInterval(long long interval) {
+    TraceInterval = std::max(0LL, interval);
+    NextSample = 0;
+    Trace.clear();
+}
+
+bool Instrumentation::writeTrace(const std::string& path) const {
+    bool json = path.size() >= 5 and path.compare(path.size() - 5, 5, ".json") == 0;
+    FILE* out = std::fopen(path.c_str(), "w");
+    if (!out)
+        return false;
+    if (json) {
+        std::fprintf(out, "{\n  \"generations\": %lld, \"seconds\": %.6f, \"allocations\": %lld,\n  \"phases\": {", Generations, getSeconds(), getAllocations());
+        for (int i = 0; i < PHASECOUNT; i++)
+            std::fprintf(out, "%s\"%s\": {\"seconds\": %.6f, \"count\": %lld}", i > 0 ? ", " : "", getPhaseName((Phase)i),
+                         std::chrono::duration<double>(Phases[i].Total).count(), Phases[i].Count);
+        std::fprintf(out, "},\n  \"samples\": [\n");
+    }
+    else {
+        std::fprintf(out, "generation,seconds,population,allocations");
+        for (int i = 0; i < PHASECOUNT; i++)
+            std::fprintf(out, ",%s_seconds", getPhaseName((Phase)i));
+        std::fprintf(out, "\n");
+    }
+    for (size_t s = 0; s < Trace.size(); s++) {
+        const TraceSample& sample = Trace[s];
+        if (json) {
+            std::fprintf(out, "    {\"generation\": %lld, \"seconds\": %.6f, \"population\": %lld, \"allocations\": %lld",
+                         sample.Generation, sample.Seconds, sample.Population, sample.Allocations);
+            for (int i = 0; i < PHASECOUNT; i++)
+                std::fprintf(out, ", \"%s_seconds\": %.9f", getPhaseName((Phase)i), sample.PhaseSeconds[i]);
+            std::fprintf(out, "}%s\n", s + 1 < Trace.size() ? "," : "");
+        }
+        else {
+            std::fprintf(out, "%lld,%.6f,%lld,%lld", sample.Generation, sample.Seconds, sample.Population, sample.Allocations);
+            for (int i = 0; i < PHASECOUNT; i++)
+                std::fprintf(out, ",%.9f", sample.PhaseSeconds[i]);
+            std::fprintf(out, "\n");
+        }
+    }
+    if (json)
+        std::fprintf(out, "  ]\n}\n");
+    return std::fclose(out) == 0;
+}
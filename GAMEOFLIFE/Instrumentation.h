@@ -0,0 +1,142 @@
+#pragma once
+#include <chrono>
+#include <string>
+#include <vector>
+
+enum class Phase { Step, StableCheck, Render, Input };
+
+constexpr int PHASECOUNT = 4;
+
+// "step", "stable_check", "render", "input".
+const char* getPhaseName(Phase phase);
+
+// Timings and rates of a run: time per phase, generations and cell updates per
+// second, heap allocations and the recent population. Nothing is measured
+// unless an Instrumentation is attached; detached, the cost is a null check
+// per generation and per phase.
+class Instrumentation {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Length of the population series kept for the overlay.
+    static constexpr int POPULATIONSAMPLES = 256;
+
+private:
+    // Rates are averaged over windows of this many seconds.
+    static constexpr double RATEWINDOW = 0.5;
+
+    struct PhaseStats {
+        Clock::duration Last, Total, SinceSample;
+        long long Count;
+    };
+
+    // One row of the trace: the phase times are those since the previous row.
+    struct TraceSample {
+        long long Generation, Population, Allocations;
+        double Seconds;
+        double PhaseSeconds[PHASECOUNT];
+    };
+
+    PhaseStats Phases[PHASECOUNT];
+    Clock::time_point Start;
+    long long Generations;
+    long long StartAllocations;
+
+    Clock::time_point WindowStart;
+    long long WindowGenerations;
+    double WindowCells;
+    double GenerationRate, CellRate;
+
+    std::vector<long long> PopulationSeries; // ring buffer
+    int SeriesNext, SeriesSize;
+
+    long long TraceInterval, NextSample;
+    std::vector<TraceSample> Trace;
+
+    void addSample(long long generation, long long population);
+
+public:
+    Instrumentation();
+
+    // Forgets everything measured so far.
+    void restart();
+
+    void addPhaseTime(Phase phase, Clock::duration time) {
+        PhaseStats& stats = Phases[(int)phase];
+        stats.Last = time;
+        stats.Total += time;
+        stats.SinceSample += time;
+        stats.Count++;
+    }
+
+    // Called once per iterate(), which may advance several generations (Hashlife).
+    void recordGenerations(long long generation, long long advanced, long long population, double cellsPerGeneration);
+
+    double getLastMicros(Phase phase) const;
+
+    double getAverageMicros(Phase phase) const;
+
+    double getGenerationRate() const;
+
+    double getCellRate() const;
+
+    long long getGenerations() const { return Generations; }
+
+    double getSeconds() const { return std::chrono::duration<double>(Clock::now() - Start).count(); }
+
+    // Heap allocations of the stepping thread since restart(), -1 when they
+    // are not counted (see getAllocationCount()).
+    long long getAllocations() const;
+
+    // Up to count latest populations, oldest first.
+    std::vector<long long> getPopulationSeries(int count) const;
+
+    // Every interval generations a trace row is kept, 0 - no trace.
+    void setTraceInterval(long long interval);
+
+    // CSV, or JSON with the phase totals when the path ends in ".json".
+    bool writeTrace(const std::string& path) const;
+};
+
+// Adds the time until it goes out of scope to a phase; does nothing without
+// an Instrumentation.
+class PhaseTimer {
+private:
+    Instrumentation* Stats;
+    Phase Measured;
+    Instrumentation::Clock::time_point Begin;
+
+public:
+    PhaseTimer(Instrumentation* stats, Phase phase) : Stats(stats), Measured(phase) {
+        if (Stats)
+            Begin = Instrumentation::Clock::now();
+    }
+
+    ~PhaseTimer() {
+        if (Stats)
+            Stats->addPhaseTime(Measured, Instrumentation::Clock::now() - Begin);
+    }
+
+    // For a phase that turned out to wait for the user.
+    void cancel() { Stats = nullptr; }
+};
+
+// Count of operator new calls made inside CountedAllocations scopes, kept by
+// the replacement operators in Instrumentation.cpp. Those are only built with
+// LIFE_COUNT_ALLOCATIONS (CMake option GAMEOFLIFE_COUNT_ALLOCATIONS); without
+// it nothing is counted and the count is -1.
+long long getAllocationCount();
+
+// Counts the allocations of the current thread while in scope. iterate()
+// opens one, so only stepping is counted, not drawing or other threads.
+class CountedAllocations {
+private:
+    bool WasCounted;
+
+public:
+    CountedAllocations();
+    ~CountedAllocations();
+
+    CountedAllocations(const CountedAllocations&) = delete;
+    CountedAllocations& operator=(const CountedAllocations&) = delete;
+};
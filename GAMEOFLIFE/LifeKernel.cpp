@@ -0,0 +1,355 @@
+#include "LifeKernel.h"
+#include <algorithm>
+#include <cctype>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define LIFE_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang only allow wider intrinsics inside functions compiled for that
+// instruction set; MSVC accepts them anywhere.
+#if defined(__GNUC__) || defined(__clang__)
+#define LIFE_TARGET(isa) __attribute__((target(isa)))
+#else
+#define LIFE_TARGET(isa)
+#endif
+
+// The last word of a row is stepped apart from the loop: its east neighbors
+// come from the ghost word at another shift, and its padding is masked.
+static void stepSpanScalar(const uint64_t* up, const uint64_t* mid, const uint64_t* down, uint64_t* out,
+                           int begin, int end, int words, int width, uint64_t lastWordMask,
+                           uint64_t* changed, int* population, RuleMasks) {
+    for (int i = begin; i < std::min(end, words - 1); i++) {
+        uint64_t next = stepWord(up, mid, down, i, 63);
+        changed[i] |= next ^ mid[i];
+        population[i] += popcount64(next);
+        out[i] = next;
+    }
+    if (end == words) {
+        int i = words - 1;
+        uint64_t next = stepWord(up, mid, down, i, (width - 1) & 63) & lastWordMask;
+        changed[i] |= next ^ mid[i];
+        population[i] += popcount64(next);
+        out[i] = next;
+    }
+}
+
+// Scalar kernel of any Life-like rule. Instantiated with constant masks for the
+// common rules; with Birth == Survival == 0 it reads the masks of the rule argument.
+template <uint16_t Birth, uint16_t Survival>
+static void stepSpanRule(const uint64_t* up, const uint64_t* mid, const uint64_t* down, uint64_t* out,
+                         int begin, int end, int words, int width, uint64_t lastWordMask,
+                         uint64_t* changed, int* population, RuleMasks rule) {
+    uint16_t birth = Birth == 0 and Survival == 0 ? rule.Birth : Birth;
+    uint16_t survival = Birth == 0 and Survival == 0 ? rule.Survival : Survival;
+    for (int i = begin; i < std::min(end, words - 1); i++) {
+        uint64_t next = stepRuleWord(birth, survival, up, mid, down, i, 63);
+        changed[i] |= next ^ mid[i];
+        population[i] += popcount64(next);
+        out[i] = next;
+    }
+    if (end == words) {
+        int i = words - 1;
+        uint64_t next = stepRuleWord(birth, survival, up, mid, down, i, (width - 1) & 63) & lastWordMask;
+        changed[i] |= next ^ mid[i];
+        population[i] += popcount64(next);
+        out[i] = next;
+    }
+}
+
+static uint64_t reverseBits64(uint64_t word) {
+    word = ((word >> 1) & 0x5555555555555555ULL) | ((word & 0x5555555555555555ULL) << 1);
+    word = ((word >> 2) & 0x3333333333333333ULL) | ((word & 0x3333333333333333ULL) << 2);
+    word = ((word >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((word & 0x0F0F0F0F0F0F0F0FULL) << 4);
+    word = ((word >> 8) & 0x00FF00FF00FF00FFULL) | ((word & 0x00FF00FF00FF00FFULL) << 8);
+    word = ((word >> 16) & 0x0000FFFF0000FFFFULL) | ((word & 0x0000FFFF0000FFFFULL) << 16);
+    return (word >> 32) | (word << 32);
+}
+
+// The whole padded row reversed word by word, then shifted down by the padding.
+void mirrorRow(const uint64_t* src, uint64_t* dst, int words, int width) {
+    int padding = words * 64 - width;
+    for (int i = 0; i < words; i++) {
+        uint64_t word = reverseBits64(src[words - 1 - i]) >> padding;
+        if (padding > 0 and i + 1 < words)
+            word |= reverseBits64(src[words - 2 - i]) << (64 - padding);
+        dst[i] = word;
+    }
+}
+
+void fillGhostCells(BitBoard& board, BoundaryKind boundary) {
+    int width = board.getWidth(), height = board.getHeight(), words = board.getWordsPerRow();
+    if (height == 0 or words == 0)
+        return;
+    uint64_t* above = board.row(-1);
+    uint64_t* below = board.row(height);
+    switch (boundary) {
+    case BoundaryKind::Torus:
+        std::copy(board.row(height - 1), board.row(height - 1) + words, above);
+        std::copy(board.row(0), board.row(0) + words, below);
+        break;
+    case BoundaryKind::Klein:
+        mirrorRow(board.row(height - 1), above, words, width);
+        mirrorRow(board.row(0), below, words, width);
+        break;
+    default:
+        std::fill(above, above + words, 0);
+        std::fill(below, below + words, 0);
+        break;
+    }
+    // The ghost rows get ghost words too: those are the corner cells.
+    bool wrap = boundary != BoundaryKind::Dead;
+    for (int y = -1; y <= height; y++)
+        fillRowGhosts(board.row(y), words, width, wrap);
+}
+
+static const char* const BOUNDARYNAMES[] = { "torus", "dead", "klein", "cylinder" };
+
+const char* getBoundaryName(BoundaryKind kind) {
+    return BOUNDARYNAMES[(int)kind];
+}
+
+bool parseBoundaryName(const char* name, BoundaryKind& kind) {
+    for (int candidate = 0; candidate < 4; candidate++) {
+        const char* candidateName = BOUNDARYNAMES[candidate];
+        size_t i = 0;
+        while (name[i] != '\0' and std::tolower((unsigned char)name[i]) == candidateName[i])
+            i++;
+        if (name[i] == '\0' and candidateName[i] == '\0') {
+            kind = (BoundaryKind)candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+#define LIFE_RULE(BIRTH, SURVIVAL) { { countMask(BIRTH), countMask(SURVIVAL) }, stepSpanRule<countMask(BIRTH), countMask(SURVIVAL)> }
+
+static const struct {
+    RuleMasks Rule;
+    StepSpanFunction Function;
+} SPECIALIZEDRULES[] = {
+    LIFE_RULE("36", "23"),        // HighLife
+    LIFE_RULE("3678", "34678"),   // Day & Night
+    LIFE_RULE("2", ""),           // Seeds
+    LIFE_RULE("3", "012345678"),  // Life without Death
+    LIFE_RULE("36", "125"),       // 2x2
+    LIFE_RULE("3", "12345"),      // Maze
+    LIFE_RULE("368", "245"),      // Move
+    LIFE_RULE("35678", "5678"),   // Diamoeba
+    LIFE_RULE("1357", "1357"),    // Replicator
+    LIFE_RULE("34", "34"),        // 34 Life
+};
+
+#undef LIFE_RULE
+
+#ifdef LIFE_X86
+
+// Vector span kernel. Words are processed LANES at a time, the west/east
+// neighbors coming from loads shifted by one word, the ghost word before the
+// row included; the last word of the row and the rest of the span go through
+// the scalar kernel.
+// PREFIX and SUFFIX spell the intrinsic names, e.g. _mm256_and_si256; SLLI,
+// SRLI and ANDNOT name the word shifts and the andnot.
+#define LIFE_VECTOR_SPAN(NAME, ISA, VTYPE, PREFIX, SUFFIX, LANES, SLLI, SRLI, ANDNOT)                   \
+LIFE_TARGET(ISA) static void NAME(const uint64_t* up, const uint64_t* mid, const uint64_t* down,       \
+                                  uint64_t* out, int begin, int end, int words, int width,             \
+                                  uint64_t lastWordMask, uint64_t* changed, int* population,           \
+                                  RuleMasks rule) {                                                    \
+    const uint64_t* rows[3] = { up, mid, down };                                                       \
+    int i = begin;                                                                                     \
+    int vectorEnd = end < words - 1 ? end : words - 1;                                                 \
+    for (; i + LANES <= vectorEnd; i += LANES) {                                                       \
+        VTYPE west[3], centre[3], east[3];                                                             \
+        for (int r = 0; r < 3; r++) {                                                                  \
+            VTYPE before = PREFIX##_loadu_##SUFFIX((const VTYPE*)(rows[r] + i - 1));                   \
+            VTYPE current = PREFIX##_loadu_##SUFFIX((const VTYPE*)(rows[r] + i));                      \
+            VTYPE after = PREFIX##_loadu_##SUFFIX((const VTYPE*)(rows[r] + i + 1));                    \
+            west[r] = PREFIX##_or_##SUFFIX(SLLI(current, 1), SRLI(before, 63));                        \
+            east[r] = PREFIX##_or_##SUFFIX(SRLI(current, 1), SLLI(after, 63));                         \
+            centre[r] = current;                                                                       \
+        }                                                                                              \
+        VTYPE t0 = PREFIX##_xor_##SUFFIX(west[0], centre[0]);                                          \
+        VTYPE s0 = PREFIX##_xor_##SUFFIX(t0, east[0]);                                                 \
+        VTYPE c0 = PREFIX##_or_##SUFFIX(PREFIX##_and_##SUFFIX(west[0], centre[0]), PREFIX##_and_##SUFFIX(t0, east[0])); \
+        VTYPE t1 = PREFIX##_xor_##SUFFIX(west[2], centre[2]);                                          \
+        VTYPE s1 = PREFIX##_xor_##SUFFIX(t1, east[2]);                                                 \
+        VTYPE c1 = PREFIX##_or_##SUFFIX(PREFIX##_and_##SUFFIX(west[2], centre[2]), PREFIX##_and_##SUFFIX(t1, east[2])); \
+        VTYPE s2 = PREFIX##_xor_##SUFFIX(west[1], east[1]);                                            \
+        VTYPE c2 = PREFIX##_and_##SUFFIX(west[1], east[1]);                                            \
+        VTYPE t3 = PREFIX##_xor_##SUFFIX(s0, s1);                                                      \
+        VTYPE ones = PREFIX##_xor_##SUFFIX(t3, s2);                                                    \
+        VTYPE c3 = PREFIX##_or_##SUFFIX(PREFIX##_and_##SUFFIX(s0, s1), PREFIX##_and_##SUFFIX(t3, s2)); \
+        VTYPE t4 = PREFIX##_xor_##SUFFIX(c0, c1);                                                      \
+        VTYPE twosLow = PREFIX##_xor_##SUFFIX(t4, c2);                                                 \
+        VTYPE c4 = PREFIX##_or_##SUFFIX(PREFIX##_and_##SUFFIX(c0, c1), PREFIX##_and_##SUFFIX(t4, c2)); \
+        VTYPE twos = PREFIX##_xor_##SUFFIX(twosLow, c3);                                               \
+        VTYPE c5 = PREFIX##_and_##SUFFIX(twosLow, c3);                                                 \
+        VTYPE next = ANDNOT(PREFIX##_or_##SUFFIX(c4, c5),                                              \
+            PREFIX##_and_##SUFFIX(twos, PREFIX##_or_##SUFFIX(ones, centre[1])));                       \
+        VTYPE flipped = PREFIX##_xor_##SUFFIX(next, centre[1]);                                        \
+        VTYPE changedSoFar = PREFIX##_loadu_##SUFFIX((const VTYPE*)(changed + i));                     \
+        PREFIX##_storeu_##SUFFIX((VTYPE*)(changed + i), PREFIX##_or_##SUFFIX(changedSoFar, flipped));  \
+        PREFIX##_storeu_##SUFFIX((VTYPE*)(out + i), next);                                             \
+        for (int lane = 0; lane < LANES; lane++)                                                       \
+            population[i + lane] += popcount64(out[i + lane]);                                         \
+    }                                                                                                  \
+    stepSpanScalar(up, mid, down, out, i, end, words, width, lastWordMask, changed, population, rule); \
+}
+
+// GCC builds the unmasked AVX-512 shifts and andnot on an undefined vector and
+// warns about it under -Wall; the zero-masked forms start from zero instead.
+#define LIFE_AVX512_SLLI(value, count) _mm512_maskz_slli_epi64(0xFF, value, count)
+#define LIFE_AVX512_SRLI(value, count) _mm512_maskz_srli_epi64(0xFF, value, count)
+#define LIFE_AVX512_ANDNOT(first, second) _mm512_maskz_andnot_epi64(0xFF, first, second)
+
+LIFE_VECTOR_SPAN(stepSpanSse2, "sse2", __m128i, _mm, si128, 2, _mm_slli_epi64, _mm_srli_epi64, _mm_andnot_si128)
+LIFE_VECTOR_SPAN(stepSpanAvx2, "avx2", __m256i, _mm256, si256, 4, _mm256_slli_epi64, _mm256_srli_epi64, _mm256_andnot_si256)
+LIFE_VECTOR_SPAN(stepSpanAvx512, "avx512f", __m512i, _mm512, si512, 8, LIFE_AVX512_SLLI, LIFE_AVX512_SRLI, LIFE_AVX512_ANDNOT)
+
+#undef LIFE_AVX512_SLLI
+#undef LIFE_AVX512_SRLI
+#undef LIFE_AVX512_ANDNOT
+#undef LIFE_VECTOR_SPAN
+
+struct CpuFeatures {
+    bool SSE2, AVX2, AVX512;
+};
+
+static CpuFeatures queryCpuFeatures() {
+    CpuFeatures features = { false, false, false };
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+    __cpuid(info, 1);
+    features.SSE2 = (info[3] & (1 << 26)) != 0;
+    bool osSavesYmm = false, osSavesZmm = false;
+    if ((info[2] & (1 << 27)) and (info[2] & (1 << 28))) { // OSXSAVE and AVX
+        unsigned long long xcr0 = _xgetbv(0);
+        osSavesYmm = (xcr0 & 0x6) == 0x6;
+        osSavesZmm = (xcr0 & 0xE6) == 0xE6;
+    }
+    if (maxLeaf >= 7) {
+        __cpuidex(info, 7, 0);
+        features.AVX2 = osSavesYmm and (info[1] & (1 << 5));
+        features.AVX512 = osSavesZmm and (info[1] & (1 << 16));
+    }
+#else
+    __builtin_cpu_init();
+    features.SSE2 = __builtin_cpu_supports("sse2");
+    features.AVX2 = __builtin_cpu_supports("avx2");
+    features.AVX512 = __builtin_cpu_supports("avx512f");
+#endif
+    return features;
+}
+
+#endif
+
+bool isKernelSupported(KernelKind kind) {
+#ifdef LIFE_X86
+    static const CpuFeatures features = queryCpuFeatures();
+    switch (kind) {
+    case KernelKind::SSE2:
+        return features.SSE2;
+    case KernelKind::AVX2:
+        return features.AVX2;
+    case KernelKind::AVX512:
+        return features.AVX512;
+    default:
+        return true;
+    }
+#else
+    return kind == KernelKind::Scalar;
+#endif
+}
+
+KernelKind detectBestKernel() {
+    static const KernelKind best =
+        isKernelSupported(KernelKind::AVX512) ? KernelKind::AVX512 :
+        isKernelSupported(KernelKind::AVX2) ? KernelKind::AVX2 :
+        isKernelSupported(KernelKind::SSE2) ? KernelKind::SSE2 : KernelKind::Scalar;
+    return best;
+}
+
+const char* getKernelName(KernelKind kind) {
+    switch (kind) {
+    case KernelKind::SSE2:
+        return "SSE2";
+    case KernelKind::AVX2:
+        return "AVX2";
+    case KernelKind::AVX512:
+        return "AVX-512";
+    default:
+        return "Scalar";
+    }
+}
+
+bool parseKernelName(const char* name, KernelKind& kind) {
+    const KernelKind kinds[] = { KernelKind::Scalar, KernelKind::SSE2, KernelKind::AVX2, KernelKind::AVX512 };
+    for (KernelKind candidate : kinds) {
+        const char* candidateName = getKernelName(candidate);
+        size_t i = 0;
+        while (name[i] != '\0' and std::tolower((unsigned char)name[i]) == std::tolower((unsigned char)candidateName[i]))
+            i++;
+        if (name[i] == '\0' and candidateName[i] == '\0') {
+            kind = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+StepSpanFunction getStepSpanFunction(KernelKind kind, RuleMasks rule) {
+    if (rule != CONWAYRULE) {
+        for (const auto& specialized : SPECIALIZEDRULES)
+            if (specialized.Rule == rule)
+                return specialized.Function;
+        return stepSpanRule<0, 0>;
+    }
+    if (!isKernelSupported(kind))
+        return stepSpanScalar;
+#ifdef LIFE_X86
+    switch (kind) {
+    case KernelKind::SSE2:
+        return stepSpanSse2;
+    case KernelKind::AVX2:
+        return stepSpanAvx2;
+    case KernelKind::AVX512:
+        return stepSpanAvx512;
+    default:
+        break;
+    }
+#endif
+    return stepSpanScalar;
+}
+
+void stepSpan(const BitBoard& src, BitBoard& dst, int yBegin, int yEnd, int wordBegin, int wordEnd,
+              KernelKind kind, uint64_t* changed, int* population, RuleMasks rule) {
+    StepSpanFunction stepRow = getStepSpanFunction(kind, rule);
+    for (int y = yBegin; y < yEnd; y++)
+        stepRow(src.row(y - 1), src.row(y), src.row(y + 1), dst.row(y),
+                wordBegin, wordEnd, src.getWordsPerRow(), src.getWidth(), src.getLastWordMask(), changed, population, rule);
+}
+
+StepResult stepRows(const BitBoard& src, BitBoard& dst, int yBegin, int yEnd, KernelKind kind, RuleMasks rule) {
+    int words = src.getWordsPerRow();
+    std::vector<uint64_t> changed(words);
+    std::vector<int> population(words);
+    stepSpan(src, dst, yBegin, yEnd, 0, words, kind, changed.data(), population.data(), rule);
+    StepResult result = { 0, false };
+    for (int i = 0; i < words; i++) {
+        result.Population += population[i];
+        result.Changed = result.Changed or changed[i] != 0;
+    }
+    return result;
+}
+
+StepResult stepBoard(BitBoard& src, BitBoard& dst, KernelKind kind, RuleMasks rule, BoundaryKind boundary) {
+    fillGhostCells(src, boundary);
+    return stepRows(src, dst, 0, src.getHeight(), kind, rule);
+}
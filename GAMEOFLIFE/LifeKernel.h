@@ -0,0 +1,168 @@
+#pragma once
+#include "BitBoard.h"
+
+struct StepResult {
+    int Population;
+    bool Changed;
+};
+
+// Life-like rule as neighbor-count masks: bit n of Birth (Survival) set - a
+// dead (live) cell with n live neighbors is alive in the next generation.
+struct RuleMasks {
+    uint16_t Birth, Survival;
+
+    bool operator==(const RuleMasks& other) const { return Birth == other.Birth and Survival == other.Survival; }
+
+    bool operator!=(const RuleMasks& other) const { return !(*this == other); }
+};
+
+// Mask of the neighbor counts spelled by the digits, countMask("23") == 0x0C.
+constexpr uint16_t countMask(const char* digits) {
+    return *digits == '\0' ? 0 : (uint16_t)((1 << (*digits - '0')) | countMask(digits + 1));
+}
+
+constexpr RuleMasks CONWAYRULE = { countMask("3"), countMask("23") };
+
+// What lies beyond the edges of the board. Torus: both pairs of opposite
+// edges are glued together. Dead: nothing, the cells outside are always dead.
+// Klein bottle: left and right are glued like on the torus, top and bottom
+// with a mirror turn, so what leaves at the top at column x comes back at the
+// bottom at column Width - 1 - x. Cylinder: left and right glued, top and
+// bottom dead.
+enum class BoundaryKind { Torus, Dead, Klein, Cylinder };
+
+const char* getBoundaryName(BoundaryKind kind);
+
+// Inverse of getBoundaryName(), ignoring case.
+bool parseBoundaryName(const char* name, BoundaryKind& kind);
+
+// The ghost words around one row of words words (see BitBoard): the cells
+// beyond its left and right ends, from the row itself when it wraps.
+inline void fillRowGhosts(uint64_t* row, int words, int width, bool wrap) {
+    row[-1] = wrap ? ((row[words - 1] >> ((width - 1) & 63)) & 1) << 63 : 0;
+    row[words] = wrap ? row[0] & 1 : 0;
+}
+
+// dst = src mirrored, cell x of dst being cell width - 1 - x of src.
+void mirrorRow(const uint64_t* src, uint64_t* dst, int words, int width);
+
+// Fills the ghost rows and words of the board for the boundary, once per
+// generation, so that the kernels read the neighbors of the edge cells like
+// any other and never wrap or check bounds themselves.
+void fillGhostCells(BitBoard& board, BoundaryKind boundary);
+
+// Neighbors of every cell of word i lined up with the cell itself: bit b of
+// westNeighbors() is cell (x - 1), bit b of eastNeighbors() is cell (x + 1).
+// The first and the last word borrow from the ghost words of the row.
+inline uint64_t westNeighbors(const uint64_t* row, int i) {
+    return (row[i] << 1) | (row[i - 1] >> 63);
+}
+
+// eastShift is 63 but for the last word of the row, where the east ghost cell
+// goes next to the last cell of the board: (width - 1) & 63.
+inline uint64_t eastNeighbors(const uint64_t* row, int i, int eastShift) {
+    return (row[i] >> 1) | (row[i + 1] << eastShift);
+}
+
+// Bit-sliced B3/S23 rule for 64 cells at once. The eight neighbor words are
+// summed with full adders into ones/twos bits plus a "four or more" flag.
+inline uint64_t lifeWord(uint64_t alive,
+                         uint64_t n0, uint64_t n1, uint64_t n2, uint64_t n3,
+                         uint64_t n4, uint64_t n5, uint64_t n6, uint64_t n7) {
+    uint64_t t0 = n0 ^ n1, s0 = t0 ^ n2, c0 = (n0 & n1) | (t0 & n2);
+    uint64_t t1 = n3 ^ n4, s1 = t1 ^ n5, c1 = (n3 & n4) | (t1 & n5);
+    uint64_t s2 = n6 ^ n7, c2 = n6 & n7;
+    uint64_t t3 = s0 ^ s1, ones = t3 ^ s2, c3 = (s0 & s1) | (t3 & s2);
+    uint64_t t4 = c0 ^ c1, twosLow = t4 ^ c2, c4 = (c0 & c1) | (t4 & c2);
+    uint64_t twos = twosLow ^ c3, c5 = twosLow & c3;
+    return ~(c4 | c5) & twos & (ones | alive);
+}
+
+// Any Life-like rule, bit-sliced: the neighbor words are summed into a
+// four-bit count per cell (ones, twos, fours, eights), which is then matched
+// against the masks. Called with constant masks, the comparisons for counts the
+// rule does not use fold away.
+inline uint64_t ruleWord(uint16_t birth, uint16_t survival, uint64_t alive,
+                         uint64_t n0, uint64_t n1, uint64_t n2, uint64_t n3,
+                         uint64_t n4, uint64_t n5, uint64_t n6, uint64_t n7) {
+    uint64_t t0 = n0 ^ n1, s0 = t0 ^ n2, c0 = (n0 & n1) | (t0 & n2);
+    uint64_t t1 = n3 ^ n4, s1 = t1 ^ n5, c1 = (n3 & n4) | (t1 & n5);
+    uint64_t s2 = n6 ^ n7, c2 = n6 & n7;
+    uint64_t t3 = s0 ^ s1, ones = t3 ^ s2, c3 = (s0 & s1) | (t3 & s2);
+    uint64_t t4 = c0 ^ c1, twosLow = t4 ^ c2, c4 = (c0 & c1) | (t4 & c2);
+    uint64_t twos = twosLow ^ c3, c5 = twosLow & c3;
+    uint64_t fours = c4 ^ c5, eights = c4 & c5;
+    uint64_t born = 0, kept = 0;
+#define LIFE_COUNT(n)                                                                                  \
+    if (((birth | survival) >> n) & 1) {                                                               \
+        uint64_t match = ((n) & 1 ? ones : ~ones) & ((n) & 2 ? twos : ~twos) &                         \
+                         ((n) & 4 ? fours : ~fours) & ((n) & 8 ? eights : ~eights);                    \
+        if ((birth >> n) & 1) born |= match;                                                           \
+        if ((survival >> n) & 1) kept |= match;                                                        \
+    }
+    LIFE_COUNT(0) LIFE_COUNT(1) LIFE_COUNT(2) LIFE_COUNT(3) LIFE_COUNT(4)
+    LIFE_COUNT(5) LIFE_COUNT(6) LIFE_COUNT(7) LIFE_COUNT(8)
+#undef LIFE_COUNT
+    return (born & ~alive) | (kept & alive);
+}
+
+// Next state of word i of the middle row, padding bits of the last word not masked.
+inline uint64_t stepWord(const uint64_t* up, const uint64_t* mid, const uint64_t* down, int i, int eastShift) {
+    return lifeWord(mid[i],
+        westNeighbors(up, i), up[i], eastNeighbors(up, i, eastShift),
+        westNeighbors(mid, i), eastNeighbors(mid, i, eastShift),
+        westNeighbors(down, i), down[i], eastNeighbors(down, i, eastShift));
+}
+
+// Same for any Life-like rule.
+inline uint64_t stepRuleWord(uint16_t birth, uint16_t survival, const uint64_t* up, const uint64_t* mid, const uint64_t* down,
+                             int i, int eastShift) {
+    return ruleWord(birth, survival, mid[i],
+        westNeighbors(up, i), up[i], eastNeighbors(up, i, eastShift),
+        westNeighbors(mid, i), eastNeighbors(mid, i, eastShift),
+        westNeighbors(down, i), down[i], eastNeighbors(down, i, eastShift));
+}
+
+// Stepping kernels. Scalar is the portable reference implementation, the
+// others process 128/256/512 cells per instruction and need the matching CPU.
+// The vector kernels implement B3/S23 only; other rules always run scalar.
+enum class KernelKind { Scalar, SSE2, AVX2, AVX512 };
+
+// Computes words [begin, end) of one row of the next generation from the three
+// source rows around it, their ghost words filled. For every word i of the
+// span, changed[i] collects the bits that flipped and population[i] counts the
+// live cells. Kernels compiled for one rule ignore the rule argument.
+typedef void (*StepSpanFunction)(const uint64_t* up, const uint64_t* mid, const uint64_t* down, uint64_t* out,
+                                 int begin, int end, int words, int width, uint64_t lastWordMask,
+                                 uint64_t* changed, int* population, RuleMasks rule);
+
+bool isKernelSupported(KernelKind kind);
+
+// Fastest kernel the CPU supports, detected once via CPUID.
+KernelKind detectBestKernel();
+
+const char* getKernelName(KernelKind kind);
+
+// Inverse of getKernelName(), ignoring case.
+bool parseKernelName(const char* name, KernelKind& kind);
+
+// Kernel for the rule: B3/S23 gets the requested instruction set, common rules
+// (HighLife, Day & Night, Seeds...) a scalar kernel compiled for their masks,
+// and any other rule the kernel that reads the masks at run time.
+StepSpanFunction getStepSpanFunction(KernelKind kind, RuleMasks rule = CONWAYRULE);
+
+// Steps the block of rows [yBegin, yEnd) and words [wordBegin, wordEnd) of the
+// board src, its ghost cells filled, into dst. changed and population are
+// indexed by word column and accumulate over the rows of the block.
+void stepSpan(const BitBoard& src, BitBoard& dst, int yBegin, int yEnd, int wordBegin, int wordEnd,
+              KernelKind kind, uint64_t* changed, int* population, RuleMasks rule = CONWAYRULE);
+
+// Steps rows [yBegin, yEnd) of the board src, its ghost cells filled, into dst.
+// The rows just outside the range are only read from src, so disjoint bands can
+// run in parallel.
+StepResult stepRows(const BitBoard& src, BitBoard& dst, int yBegin, int yEnd, KernelKind kind, RuleMasks rule = CONWAYRULE);
+
+// Fills the ghost cells of src for the boundary, then steps the whole board
+// into dst, which must have the same size.
+StepResult stepBoard(BitBoard& src, BitBoard& dst, KernelKind kind, RuleMasks rule = CONWAYRULE,
+                     BoundaryKind boundary = BoundaryKind::Torus);
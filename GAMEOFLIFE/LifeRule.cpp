@@ -0,0 +1,175 @@
+#include "LifeRule.h"
+#include <cctype>
+
+constexpr int LifeRule::MAXRANGE;
+constexpr int LifeRule::MAXSTATES;
+
+LifeRule::LifeRule() : Range(1), States(2), CountSelf(false), Birth(9, 0), Survival(9, 0) {
+    Birth[3] = 1;
+    Survival[2] = Survival[3] = 1;
+}
+
+static uint16_t getMask(const std::vector<uint8_t>& table) {
+    uint16_t mask = 0;
+    for (size_t n = 0; n < table.size() and n < 16; n++)
+        if (table[n])
+            mask |= (uint16_t)(1 << n);
+    return mask;
+}
+
+uint16_t LifeRule::getBirthMask() const {
+    return getMask(Birth);
+}
+
+uint16_t LifeRule::getSurvivalMask() const {
+    return getMask(Survival);
+}
+
+// Digits of a B or S list: every digit is a neighbor count from 0 to 8.
+static bool parseCounts(const std::string& digits, std::vector<uint8_t>& table) {
+    table.assign(9, 0);
+    for (char c : digits) {
+        if (c < '0' or c > '8')
+            return false;
+        table[c - '0'] = 1;
+    }
+    return true;
+}
+
+static bool parseNumber(const std::string& text, int minimum, int maximum, int& value) {
+    if (text.empty() or text.size() > 4)
+        return false;
+    value = 0;
+    for (char c : text) {
+        if (c < '0' or c > '9')
+            return false;
+        value = value * 10 + (c - '0');
+    }
+    return value >= minimum and value <= maximum;
+}
+
+static std::vector<std::string> split(const std::string& text, char separator) {
+    std::vector<std::string> parts(1);
+    for (char c : text) {
+        if (c == separator)
+            parts.emplace_back();
+        else
+            parts.back() += c;
+    }
+    return parts;
+}
+
+// "a..b" into table[a..b]; empty for no counts at all.
+static bool parseInterval(const std::string& text, int maxCount, std::vector<uint8_t>& table) {
+    if (text.empty())
+        return true;
+    size_t dots = text.find("..");
+    int low, high;
+    if (dots == std::string::npos or !parseNumber(text.substr(0, dots), 0, maxCount, low) or
+        !parseNumber(text.substr(dots + 2), low, maxCount, high))
+        return false;
+    for (int n = low; n <= high; n++)
+        table[n] = 1;
+    return true;
+}
+
+static bool parseLargerThanLife(const std::string& text, LifeRule& rule) {
+    LifeRule parsed;
+    std::vector<std::string> fields = split(text, ',');
+    if (fields.size() != 6 or fields[0][0] != 'r' or !parseNumber(fields[0].substr(1), 1, LifeRule::MAXRANGE, parsed.Range))
+        return false;
+    int states, middle;
+    if (fields[1][0] != 'c' or !parseNumber(fields[1].substr(1), 0, LifeRule::MAXSTATES, states) or states == 1 or
+        fields[2][0] != 'm' or !parseNumber(fields[2].substr(1), 0, 1, middle) or fields[5] != "nm")
+        return false;
+    parsed.States = states == 0 ? 2 : states;
+    parsed.CountSelf = middle == 1;
+    int maxCount = parsed.getMaxCount();
+    parsed.Birth.assign(maxCount + 1, 0);
+    parsed.Survival.assign(maxCount + 1, 0);
+    if (fields[3][0] != 's' or !parseInterval(fields[3].substr(1), maxCount, parsed.Survival) or
+        fields[4][0] != 'b' or !parseInterval(fields[4].substr(1), maxCount, parsed.Birth))
+        return false;
+    rule = parsed;
+    return true;
+}
+
+bool parseRule(const std::string& text, LifeRule& rule) {
+    std::string compact;
+    for (char c : text)
+        if (!std::isspace((unsigned char)c))
+            compact += (char)std::tolower((unsigned char)c);
+    size_t topology = compact.find(':'); // Golly's bounded grid suffix, B3/S23:T100,100
+    if (topology != std::string::npos)
+        compact.erase(topology);
+    if (compact.empty())
+        return false;
+    if (compact[0] == 'r')
+        return parseLargerThanLife(compact, rule) and !rule.Birth[0];
+
+    size_t survivalStart = compact.find('s');
+    if (compact[0] == 'b' and compact.find('/') == std::string::npos and survivalStart != std::string::npos)
+        compact.insert(survivalStart, "/"); // B3S23
+    LifeRule parsed;
+    std::vector<std::string> parts = split(compact, '/');
+    if (parts.size() < 2 or parts.size() > 3)
+        return false;
+    std::string birth, survival, states;
+    if (!parts[0].empty() and parts[0][0] == 'b') {
+        // B3/S23 or B2/S/C3
+        if (parts[1].empty() or parts[1][0] != 's')
+            return false;
+        birth = parts[0].substr(1);
+        survival = parts[1].substr(1);
+        if (parts.size() == 3) {
+            if (parts[2].empty() or (parts[2][0] != 'c' and parts[2][0] != 'g'))
+                return false;
+            states = parts[2].substr(1);
+        }
+    }
+    else {
+        // 23/3 or /2/3: survival first
+        survival = parts[0];
+        birth = parts[1];
+        if (parts.size() == 3)
+            states = parts[2];
+    }
+    if (!parseCounts(birth, parsed.Birth) or !parseCounts(survival, parsed.Survival) or parsed.Birth[0])
+        return false;
+    if (!states.empty() and !parseNumber(states, 2, LifeRule::MAXSTATES, parsed.States))
+        return false;
+    rule = parsed;
+    return true;
+}
+
+static std::string formatCounts(const std::vector<uint8_t>& table) {
+    std::string digits;
+    for (size_t n = 0; n < table.size(); n++)
+        if (table[n])
+            digits += (char)('0' + n);
+    return digits;
+}
+
+// The first run of counts of the table as "a..b", which is all a Larger than
+// Life rule can hold.
+static std::string formatInterval(const std::vector<uint8_t>& table) {
+    size_t low = 0;
+    while (low < table.size() and !table[low])
+        low++;
+    if (low == table.size())
+        return "";
+    size_t high = low;
+    while (high + 1 < table.size() and table[high + 1])
+        high++;
+    return std::to_string(low) + ".." + std::to_string(high);
+}
+
+std::string formatRule(const LifeRule& rule) {
+    if (rule.Range == 1 and !rule.CountSelf) {
+        std::string name = "B" + formatCounts(rule.Birth) + "/S" + formatCounts(rule.Survival);
+        return rule.States == 2 ? name : name + "/C" + std::to_string(rule.States);
+    }
+    return "R" + std::to_string(rule.Range) + ",C" + std::to_string(rule.States == 2 ? 0 : rule.States) +
+           ",M" + (rule.CountSelf ? "1" : "0") + ",S" + formatInterval(rule.Survival) +
+           ",B" + formatInterval(rule.Birth) + ",NM";
+}
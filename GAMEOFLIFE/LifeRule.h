@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Outer-totalistic rule: the next state of a cell depends only on its own
+// state and on the number of live cells in its neighborhood. Rule strings:
+//   B3/S23, 23/3                  - Life-like, the 8 Moore neighbors
+//   B2/S/C3, /2/3                 - Generations: a live cell that does not
+//                                   survive spends States - 2 generations
+//                                   dying, and dying cells are not counted
+//   R5,C0,M1,S34..58,B34..45,NM   - Larger than Life: the (2R+1)^2 box around
+//                                   the cell, M1 counting the cell itself and C
+//                                   the states as in Generations (0 for two)
+// Rules with B0 are rejected: empty space would come alive, which neither the
+// tile skipping nor the unbounded modes can represent.
+struct LifeRule {
+    static constexpr int MAXRANGE = 10;
+    static constexpr int MAXSTATES = 256;
+
+    int Range;
+    int States;
+    bool CountSelf;
+    std::vector<uint8_t> Birth, Survival; // indexed by the number of live neighbors
+
+    // B3/S23.
+    LifeRule();
+
+    int getMaxCount() const { return (2 * Range + 1) * (2 * Range + 1) - (CountSelf ? 0 : 1); }
+
+    // Two states and 8 neighbors: stepped by the bit-sliced kernels.
+    bool isLifeLike() const { return Range == 1 and States == 2 and !CountSelf; }
+
+    // Bit n set - birth (survival) with n live neighbors. Life-like rules only.
+    uint16_t getBirthMask() const;
+
+    uint16_t getSurvivalMask() const;
+
+    bool operator==(const LifeRule& other) const {
+        return Range == other.Range and States == other.States and CountSelf == other.CountSelf and
+               Birth == other.Birth and Survival == other.Survival;
+    }
+
+    bool operator!=(const LifeRule& other) const { return !(*this == other); }
+};
+
+// Accepts the forms above, ignoring case and spaces.
+bool parseRule(const std::string& text, LifeRule& rule);
+
+// Canonical B/S, B/S/C or Larger than Life form of the rule.
+std::string formatRule(const LifeRule& rule);
@@ -0,0 +1,496 @@
+#include "ObjectCensus.h"
+#include <algorithm>
+#include <climits>
+#include <functional>
+#include <map>
+#include <utility>
+
+constexpr int ObjectCensus::MAXPHASES;
+
+typedef std::vector<std::pair<int, int>> CellList;
+
+struct CatalogueEntry {
+    const char* Name;
+    const char* Plural;
+    int Period;        // generations the catalogue steps through; spaceships move meanwhile
+    const char* Cells; // rows separated by '/', 'O' for a live cell
+};
+
+// The objects that make up nearly all of what random soups settle into.
+static const CatalogueEntry CATALOGUE[] = {
+    { "block", "blocks", 1, "OO/OO" },
+    { "beehive", "beehives", 1, ".OO./O..O/.OO." },
+    { "loaf", "loaves", 1, ".OO./O..O/.O.O/..O." },
+    { "boat", "boats", 1, "OO./O.O/.O." },
+    { "ship", "ships", 1, "OO./O.O/.OO" },
+    { "tub", "tubs", 1, ".O./O.O/.O." },
+    { "pond", "ponds", 1, ".OO./O..O/O..O/.OO." },
+    { "long boat", "long boats", 1, "OO../O.O./.O.O/..O." },
+    { "long ship", "long ships", 1, "OO../O.O./.O.O/..OO" },
+    { "barge", "barges", 1, ".O../O.O./.O.O/..O." },
+    { "long barge", "long barges", 1, ".O.../O.O../.O.O./..O.O/...O." },
+    { "mango", "mangoes", 1, ".OO../O..O./.O..O/..OO." },
+    { "eater", "eaters", 1, "OO../O.O./..O./..OO" },
+    { "aircraft carrier", "aircraft carriers", 1, "OO../O..O/..OO" },
+    { "snake", "snakes", 1, "OO.O/O.OO" },
+    { "ship-tie", "ship-ties", 1, "OO..../O.O.../.OO.../...OO./...O.O/....OO" },
+    { "half-bakery", "half-bakeries", 1, ".O...../O.O..../O..O.../.OO.O../...O.O./...O..O/....OO." },
+    { "blinker", "blinkers", 2, "OOO" },
+    { "toad", "toads", 2, ".OOO/OOO." },
+    { "beacon", "beacons", 2, "OO../OO../..OO/..OO" },
+    { "clock", "clocks", 2, "..O./O.O./.O.O/.O.." },
+    { "pulsar", "pulsars", 3, "..OOO...OOO../" "............./" "O....O.O....O/" "O....O.O....O/" "O....O.O....O/" "..OOO...OOO../" "............./"
+                              "..OOO...OOO../" "O....O.O....O/" "O....O.O....O/" "O....O.O....O/" "............./" "..OOO...OOO.." },
+    { "pentadecathlon", "pentadecathlons", 15, "..O....O../OO.OOOO.OO/..O....O.." },
+    { "glider", "gliders", 4, ".O./..O/OOO" },
+    { "lightweight spaceship", "lightweight spaceships", 4, ".O..O/O..../O...O/OOOO." },
+    { "middleweight spaceship", "middleweight spaceships", 4, "...O../.O...O/O...../O....O/OOOOO." },
+    { "heavyweight spaceship", "heavyweight spaceships", 4, "...OO../.O....O/O....../O.....O/OOOOOO." },
+};
+
+// The smallest of the 8 rotations and reflections, as width, height and the
+// rows packed into bytes, so that a shape gets the same key in any orientation
+// and position.
+static std::string normalizeShape(const CellList& cells) {
+    std::string best, candidate;
+    for (int transform = 0; transform < 8; transform++) {
+        auto place = [transform](std::pair<int, int> cell) {
+            int x = cell.first, y = cell.second;
+            if (transform & 4)
+                std::swap(x, y);
+            return std::make_pair(transform & 1 ? -x : x, transform & 2 ? -y : y);
+        };
+        int minX = INT_MAX, minY = INT_MAX, maxX = INT_MIN, maxY = INT_MIN;
+        for (const auto& cell : cells) {
+            auto p = place(cell);
+            minX = std::min(minX, p.first);
+            maxX = std::max(maxX, p.first);
+            minY = std::min(minY, p.second);
+            maxY = std::max(maxY, p.second);
+        }
+        int width = maxX - minX + 1, height = maxY - minY + 1;
+        size_t rowBytes = ((size_t)width + 7) / 8;
+        candidate.assign(8 + rowBytes * height, '\0');
+        for (int i = 0; i < 4; i++) {
+            candidate[i] = (char)(width >> (24 - 8 * i));
+            candidate[4 + i] = (char)(height >> (24 - 8 * i));
+        }
+        for (const auto& cell : cells) {
+            auto p = place(cell);
+            int x = p.first - minX, y = p.second - minY;
+            candidate[8 + y * rowBytes + (x >> 3)] |= (char)(1 << (x & 7));
+        }
+        if (transform == 0 or candidate < best)
+            best.swap(candidate);
+    }
+    return best;
+}
+
+static CellList parseCells(const char* text) {
+    CellList cells;
+    for (int x = 0, y = 0; *text; text++) {
+        if (*text == '/') {
+            x = 0;
+            y++;
+            continue;
+        }
+        if (*text == 'O')
+            cells.emplace_back(x, y);
+        x++;
+    }
+    return cells;
+}
+
+// B3/S23 on an unbounded plane, only for the handful of cells of a catalogue entry.
+static CellList stepCells(const CellList& cells) {
+    std::map<std::pair<int, int>, int> counts;
+    for (const auto& cell : cells)
+        for (int dy = -1; dy <= 1; dy++)
+            for (int dx = -1; dx <= 1; dx++)
+                counts[{ cell.first + dx, cell.second + dy }] += (dx != 0 or dy != 0) ? 2 : 1;
+    // Odd counts are live cells: twice the neighbors plus one.
+    CellList next;
+    for (const auto& count : counts)
+        if (count.second == 6 or count.second == 7 or count.second == 5)
+            next.push_back(count.first);
+    return next;
+}
+
+// Every phase of every entry, normalized.
+static std::unordered_map<std::string, int> buildCatalogue() {
+    std::unordered_map<std::string, int> catalogue;
+    for (int kind = 0; kind < (int)(sizeof(CATALOGUE) / sizeof(CATALOGUE[0])); kind++) {
+        CellList cells = parseCells(CATALOGUE[kind].Cells);
+        for (int phase = 0; phase < CATALOGUE[kind].Period; phase++) {
+            catalogue.emplace(normalizeShape(cells), kind);
+            cells = stepCells(cells);
+        }
+    }
+    return catalogue;
+}
+
+static const std::unordered_map<std::string, int>& getCatalogue() {
+    static const std::unordered_map<std::string, int> catalogue = buildCatalogue();
+    return catalogue;
+}
+
+// Where to cut a circle of the given size so that the covered intervals do
+// not wrap: the start of the interval after the widest gap.
+static int findCut(std::vector<std::pair<int, int>>& intervals, int size) {
+    std::sort(intervals.begin(), intervals.end());
+    int cut = 0, widestGap = -1, reach = intervals.front().second;
+    for (size_t i = 1; i < intervals.size(); i++) {
+        if (intervals[i].first > reach and intervals[i].first - reach > widestGap) {
+            widestGap = intervals[i].first - reach;
+            cut = intervals[i].first;
+        }
+        reach = std::max(reach, intervals[i].second);
+    }
+    // The gap around the edge, from the end of the last interval to the first.
+    if (intervals.front().first + size - reach >= widestGap)
+        cut = 0;
+    return cut;
+}
+
+int ObjectCensus::findRoot(int run) {
+    while (Parent[run] != run) {
+        Parent[run] = Parent[Parent[run]];
+        run = Parent[run];
+    }
+    return run;
+}
+
+void ObjectCensus::joinRuns(int first, int second) {
+    first = findRoot(first);
+    second = findRoot(second);
+    if (first < second)
+        Parent[second] = first;
+    else if (second < first)
+        Parent[first] = second;
+}
+
+// Runs of two neighboring rows touch when they overlap or meet diagonally.
+// On a torus the last cell of a row also touches the first one of the other.
+void ObjectCensus::joinRows(int upper, int lower, int width, bool wrap) {
+    int i = RowBegin[upper], iEnd = RowBegin[upper + 1];
+    int j = RowBegin[lower], jEnd = RowBegin[lower + 1];
+    if (i == iEnd or j == jEnd)
+        return;
+    if (wrap) {
+        if (Runs[iEnd - 1].End == width and Runs[j].Start == 0)
+            joinRuns(iEnd - 1, j);
+        if (Runs[i].Start == 0 and Runs[jEnd - 1].End == width)
+            joinRuns(i, jEnd - 1);
+    }
+    while (i < iEnd and j < jEnd) {
+        if (Runs[i].Start <= Runs[j].End and Runs[j].Start <= Runs[i].End)
+            joinRuns(i, j);
+        if (Runs[i].End <= Runs[j].End)
+            i++;
+        else
+            j++;
+    }
+}
+
+static void forEach(ThreadPool* pool, int count, const std::function<void(int)>& task) {
+    if (pool and count > 1)
+        pool->parallelFor(count, task);
+    else
+        for (int i = 0; i < count; i++)
+            task(i);
+}
+
+int ObjectCensus::labelObjects(const BitBoard& cells, bool wrap, ThreadPool* pool) {
+    int width = cells.getWidth(), height = cells.getHeight(), words = cells.getWordsPerRow();
+    int strips = pool ? std::min(height, pool->getThreadCount() * 4) : 1;
+    auto firstRow = [height, strips](int strip) { return (int)((long long)strip * height / strips); };
+
+    // The runs of each strip, each row found from its start and end bits.
+    std::vector<std::vector<Run>> stripRuns(strips);
+    RowBegin.resize(height + 1);
+    forEach(pool, strips, [&](int strip) {
+        std::vector<Run>& runs = stripRuns[strip];
+        for (int y = firstRow(strip); y < firstRow(strip + 1); y++) {
+            RowBegin[y] = (int)runs.size();
+            const uint64_t* row = cells.row(y);
+            int start = 0;
+            for (int i = 0; i < words; i++) {
+                uint64_t word = row[i];
+                if (word == 0)
+                    continue;
+                uint64_t before = i > 0 ? row[i - 1] >> 63 : 0;
+                uint64_t after = i + 1 < words ? row[i + 1] << 63 : 0;
+                uint64_t starts = word & ~((word << 1) | before);
+                uint64_t ends = word & ~((word >> 1) | after);
+                while (starts | ends) {
+                    int startBit = starts ? countTrailingZeros64(starts) : 64;
+                    int endBit = ends ? countTrailingZeros64(ends) : 64;
+                    if (startBit <= endBit) {
+                        start = i * 64 + startBit;
+                        starts &= starts - 1;
+                    }
+                    else {
+                        runs.push_back({ y, start, i * 64 + endBit + 1 });
+                        ends &= ends - 1;
+                    }
+                }
+            }
+        }
+    });
+    std::vector<int> stripBase(strips + 1, 0);
+    for (int strip = 0; strip < strips; strip++)
+        stripBase[strip + 1] = stripBase[strip] + (int)stripRuns[strip].size();
+    int runCount = stripBase[strips];
+    Runs.resize(runCount);
+    Parent.resize(runCount);
+    RowBegin[height] = runCount;
+    forEach(pool, strips, [&](int strip) {
+        std::copy(stripRuns[strip].begin(), stripRuns[strip].end(), Runs.begin() + stripBase[strip]);
+        for (int run = stripBase[strip]; run < stripBase[strip + 1]; run++)
+            Parent[run] = run;
+        for (int y = firstRow(strip); y < firstRow(strip + 1); y++)
+            RowBegin[y] += stripBase[strip];
+    });
+
+    // Each strip joins its own runs, so no two strips touch the same parents.
+    // The rows at the strip borders and around the torus are joined after.
+    forEach(pool, strips, [&](int strip) {
+        for (int y = firstRow(strip) + 1; y < firstRow(strip + 1); y++)
+            joinRows(y - 1, y, width, wrap);
+    });
+    for (int y = 0; y < height and wrap; y++) {
+        int first = RowBegin[y], last = RowBegin[y + 1] - 1;
+        if (last > first and Runs[first].Start == 0 and Runs[last].End == width)
+            joinRuns(first, last);
+    }
+    for (int strip = 1; strip < strips; strip++)
+        joinRows(firstRow(strip) - 1, firstRow(strip), width, wrap);
+    if (wrap and height > 1)
+        joinRows(height - 1, 0, width, wrap);
+
+    // Objects numbered in the order of their first run; a root is the first
+    // run of its object, as the smaller root always wins.
+    Labels.resize(runCount);
+    forEach(pool, strips, [&](int strip) {
+        for (int run = stripBase[strip]; run < stripBase[strip + 1]; run++) {
+            int root = run;
+            while (Parent[root] != root)
+                root = Parent[root];
+            Labels[run] = root;
+        }
+    });
+    int objects = 0;
+    for (int run = 0; run < runCount; run++) {
+        if (Labels[run] == run)
+            Parent[run] = objects++;
+        Labels[run] = Parent[Labels[run]];
+    }
+    ObjectBegin.assign(objects + 1, 0);
+    for (int run = 0; run < runCount; run++)
+        ObjectBegin[Labels[run] + 1]++;
+    for (int object = 0; object < objects; object++)
+        ObjectBegin[object + 1] += ObjectBegin[object];
+    ObjectRuns.resize(runCount);
+    std::vector<int> filled(ObjectBegin.begin(), ObjectBegin.end() - 1);
+    for (int run = 0; run < runCount; run++)
+        ObjectRuns[filled[Labels[run]]++] = run;
+    return objects;
+}
+
+void ObjectCensus::describeObjects(int objects, const BitBoard& board, bool wrap, ThreadPool* pool) {
+    Keys.resize(objects);
+    KeyCells.resize(objects);
+    int chunks = std::min(objects, pool ? pool->getThreadCount() * 16 : 1);
+    forEach(pool, chunks, [&](int chunk) {
+        for (int object = (int)((long long)chunk * objects / chunks); object < (int)((long long)(chunk + 1) * objects / chunks); object++)
+            describeObject(object, board, wrap, Keys[object], KeyCells[object]);
+    });
+}
+
+void ObjectCensus::tally(std::string& key, int kind, int cells) {
+    auto found = Tallies.find(key);
+    if (found != Tallies.end())
+        found->second.Count++;
+    else
+        Tallies.emplace(std::move(key), Tally{ kind, cells, 1 });
+}
+
+void ObjectCensus::take(const std::vector<BitBoard>& phases, bool wrap, bool named, ThreadPool* pool) {
+    const BitBoard& board = phases[0];
+    int width = board.getWidth(), height = board.getHeight(), words = board.getWordsPerRow();
+    if (height == 0)
+        return;
+    const BitBoard* cells = &board;
+    if (phases.size() > 1) {
+        Union = board;
+        for (size_t phase = 1; phase < phases.size(); phase++)
+            for (int y = 0; y < height; y++)
+                for (int i = 0; i < words; i++)
+                    Union.row(y)[i] |= phases[phase].row(y)[i];
+        cells = &Union;
+    }
+    const std::unordered_map<std::string, int>& catalogue = getCatalogue();
+    int pieces = labelObjects(*cells, wrap, pool);
+    describeObjects(pieces, board, wrap, pool);
+    std::vector<std::string> pieceKeys;
+    std::vector<int> pieceCells, pieceKinds(pieces, -1);
+    pieceKeys.swap(Keys);
+    pieceCells.swap(KeyCells);
+    bool hasUnknown = false;
+    for (int piece = 0; piece < pieces; piece++) {
+        auto known = named ? catalogue.find(pieceKeys[piece]) : catalogue.end();
+        if (known != catalogue.end())
+            pieceKinds[piece] = known->second;
+        else
+            hasUnknown = hasUnknown or pieceCells[piece] > 0;
+    }
+
+    // Unknown pieces up to two cells apart may be parts of one object, such
+    // as the halves of an aircraft carrier or a spaceship with a cell split
+    // off. They are grouped by growing each cell into a 2 x 2 square, so that
+    // squares touch when their cells are two apart, and labeled once more.
+    // A group counts when it is in the catalogue, its pieces one by one otherwise.
+    std::vector<int> pieceGroups(pieces, -1);
+    if (named and hasUnknown) {
+        Mask.resize(height, width);
+        Mask.clear();
+        std::vector<std::pair<int, int>> anchors(pieces);
+        for (int piece = 0; piece < pieces; piece++) {
+            if (pieceKinds[piece] >= 0 or pieceCells[piece] == 0)
+                continue;
+            for (int i = ObjectBegin[piece]; i < ObjectBegin[piece + 1]; i++) {
+                const Run& run = Runs[ObjectRuns[i]];
+                Mask.setRun(run.Start, run.Y, run.End - run.Start);
+            }
+            const Run& first = Runs[ObjectRuns[ObjectBegin[piece]]];
+            anchors[piece] = { first.Start, first.Y };
+        }
+        Parts = board;
+        Grown = Mask;
+        for (int y = 0; y < height; y++) {
+            uint64_t* parts = Parts.row(y);
+            uint64_t* grown = Grown.row(y);
+            uint64_t carry = 0;
+            for (int i = 0; i < words; i++) {
+                parts[i] &= Mask.row(y)[i];
+                uint64_t word = grown[i];
+                grown[i] = word | (word << 1) | carry;
+                carry = word >> 63;
+            }
+            grown[words - 1] &= Grown.getLastWordMask();
+            if (wrap and Mask.get(width - 1, y))
+                grown[0] |= 1;
+        }
+        std::vector<uint64_t> lastRow(Grown.row(height - 1), Grown.row(height - 1) + words);
+        for (int y = height - 1; y > 0; y--)
+            for (int i = 0; i < words; i++)
+                Grown.row(y)[i] |= Grown.row(y - 1)[i];
+        for (int i = 0; i < words and wrap and height > 1; i++)
+            Grown.row(0)[i] |= lastRow[i];
+
+        int groups = labelObjects(Grown, wrap, pool);
+        describeObjects(groups, Parts, wrap, pool);
+        std::vector<int> groupKinds(groups, -1);
+        for (int group = 0; group < groups; group++) {
+            auto known = catalogue.find(Keys[group]);
+            if (known != catalogue.end()) {
+                groupKinds[group] = known->second;
+                tally(Keys[group], known->second, KeyCells[group]);
+            }
+        }
+        for (int piece = 0; piece < pieces; piece++) {
+            if (pieceKinds[piece] >= 0 or pieceCells[piece] == 0)
+                continue;
+            int x = anchors[piece].first, y = anchors[piece].second;
+            auto run = std::upper_bound(Runs.begin() + RowBegin[y], Runs.begin() + RowBegin[y + 1], x, [](int start, const Run& run) { return start < run.Start; }) - 1;
+            pieceGroups[piece] = groupKinds[Labels[run - Runs.begin()]] >= 0 ? Labels[run - Runs.begin()] : -1;
+        }
+    }
+    for (int piece = 0; piece < pieces; piece++)
+        if (pieceCells[piece] > 0 and pieceGroups[piece] < 0)
+            tally(pieceKeys[piece], pieceKinds[piece], pieceCells[piece]);
+}
+
+// The live cells of the object in phase 0, moved off the edges of the torus.
+void ObjectCensus::describeObject(int object, const BitBoard& board, bool wrap, std::string& key, int& cells) const {
+    int width = board.getWidth(), height = board.getHeight();
+    CellList live;
+    bool left = false, right = false, top = false, bottom = false;
+    for (int i = ObjectBegin[object]; i < ObjectBegin[object + 1]; i++) {
+        const Run& run = Runs[ObjectRuns[i]];
+        for (int x = run.Start; x < run.End; x++)
+            if (board.get(x, run.Y))
+                live.emplace_back(x, run.Y);
+        left = left or run.Start == 0;
+        right = right or run.End == width;
+        top = top or run.Y == 0;
+        bottom = bottom or run.Y == height - 1;
+    }
+    cells = (int)live.size();
+    if (live.empty())
+        return;
+    if (wrap and left and right) {
+        std::vector<std::pair<int, int>> intervals;
+        for (int i = ObjectBegin[object]; i < ObjectBegin[object + 1]; i++)
+            intervals.emplace_back(Runs[ObjectRuns[i]].Start, Runs[ObjectRuns[i]].End);
+        int cut = findCut(intervals, width);
+        for (auto& cell : live)
+            cell.first = (cell.first - cut + width) % width;
+    }
+    if (wrap and top and bottom) {
+        std::vector<std::pair<int, int>> intervals;
+        for (int i = ObjectBegin[object]; i < ObjectBegin[object + 1]; i++)
+            intervals.emplace_back(Runs[ObjectRuns[i]].Y, Runs[ObjectRuns[i]].Y + 1);
+        int cut = findCut(intervals, height);
+        for (auto& cell : live)
+            cell.second = (cell.second - cut + height) % height;
+    }
+    key = normalizeShape(live);
+}
+
+void ObjectCensus::add(const ObjectCensus& other) {
+    for (const auto& tally : other.Tallies) {
+        auto inserted = Tallies.emplace(tally.first, tally.second);
+        if (!inserted.second)
+            inserted.first->second.Count += tally.second.Count;
+    }
+}
+
+long long ObjectCensus::getObjectCount() const {
+    long long count = 0;
+    for (const auto& tally : Tallies)
+        count += tally.second.Count;
+    return count;
+}
+
+std::vector<CensusCount> ObjectCensus::getCounts() const {
+    // Named objects by kind, unknown ones by size.
+    std::map<std::pair<int, int>, long long> groups;
+    for (const auto& tally : Tallies)
+        groups[{ tally.second.Kind, tally.second.Kind < 0 ? tally.second.Cells : 0 }] += tally.second.Count;
+    std::vector<CensusCount> counts;
+    for (const auto& group : groups) {
+        int kind = group.first.first;
+        counts.push_back({ kind < 0 ? "" : CATALOGUE[kind].Name, kind < 0 ? "" : CATALOGUE[kind].Plural, group.first.second, group.second });
+    }
+    std::stable_sort(counts.begin(), counts.end(), [](const CensusCount& a, const CensusCount& b) {
+        if (a.Count != b.Count)
+            return a.Count > b.Count;
+        return !a.Name.empty() and b.Name.empty();
+    });
+    return counts;
+}
+
+std::string ObjectCensus::format() const {
+    std::string text;
+    for (const CensusCount& count : getCounts()) {
+        if (!text.empty())
+            text += ", ";
+        text += std::to_string(count.Count) + " ";
+        if (count.Name.empty())
+            text += "unknown " + std::to_string(count.Cells) + "-cell " + (count.Count == 1 ? "object" : "objects");
+        else
+            text += count.Count == 1 ? count.Name : count.Plural;
+    }
+    return text.empty() ? "no objects" : text;
+}
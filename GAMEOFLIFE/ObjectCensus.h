@@ -0,0 +1,92 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "BitBoard.h"
+#include "ThreadPool.h"
+
+// One line of a census: a named object from the catalogue, or all unknown
+// objects of one size.
+struct CensusCount {
+    std::string Name;   // empty for unknown objects
+    std::string Plural;
+    int Cells;          // of the unknown objects; 0 for named ones
+    long long Count;
+};
+
+// Counts the objects of a settled board. Objects are the connected groups of
+// live cells, neighbors including diagonal ones, except that unknown groups
+// up to two cells apart are taken together when the catalogue knows the
+// result (see take()). Live cells are labeled run
+// by run: every row of cells is cut into runs of live cells, strips of rows
+// are labeled in parallel with a union-find over their runs, then the runs
+// at the strip borders (and across the edges of a torus) are joined.
+//
+// An oscillator such as the beacon falls apart into pieces in some phases, so
+// the cells are grouped by the union of all the phases of the period. Each
+// object is then normalized up to rotation and reflection and looked up in a
+// hashed catalogue of the common still lifes, oscillators and spaceships of
+// B3/S23; other rules and shapes not in the catalogue count as unknown.
+class ObjectCensus {
+private:
+    struct Run {
+        int Y, Start, End; // cells [Start, End) of row Y
+    };
+
+    struct Tally {
+        int Kind;  // index into the catalogue, -1 for unknown
+        int Cells;
+        long long Count;
+    };
+
+    // Keyed by the normalized shape.
+    std::unordered_map<std::string, Tally> Tallies;
+
+    // Scratch of take(), kept to avoid allocating for each board.
+    BitBoard Union, Mask, Parts, Grown;
+    std::vector<Run> Runs;
+    std::vector<int> RowBegin; // runs of row y are [RowBegin[y], RowBegin[y + 1])
+    std::vector<int> Parent;
+    std::vector<int> Labels;   // object of each run
+    std::vector<int> ObjectRuns, ObjectBegin;
+    std::vector<std::string> Keys;
+    std::vector<int> KeyCells;
+
+    int findRoot(int run);
+    void joinRuns(int first, int second);
+    void joinRows(int upper, int lower, int width, bool wrap);
+
+    // Labels the groups of cells and returns their number; the runs of object
+    // k are ObjectRuns[ObjectBegin[k]] ... ObjectRuns[ObjectBegin[k + 1] - 1].
+    int labelObjects(const BitBoard& cells, bool wrap, ThreadPool* pool);
+
+    // Keys and KeyCells of every object, from the cells of board under its runs.
+    void describeObjects(int objects, const BitBoard& board, bool wrap, ThreadPool* pool);
+    void describeObject(int object, const BitBoard& board, bool wrap, std::string& key, int& cells) const;
+
+    void tally(std::string& key, int kind, int cells);
+
+public:
+    // Longest period whose phases are worth stepping through for the grouping.
+    static constexpr int MAXPHASES = 64;
+
+    void clear() { Tallies.clear(); }
+
+    // Adds the objects of phases[0] to the counts. phases holds the board at
+    // the consecutive generations of one period, or only phases[0] when the
+    // period is unknown or too long. With wrap the board is a torus. Named
+    // objects need B3/S23: without named, every object is unknown.
+    void take(const std::vector<BitBoard>& phases, bool wrap, bool named, ThreadPool* pool);
+
+    // Adds the counts of another census, of the soups of another thread say.
+    void add(const ObjectCensus& other);
+
+    long long getObjectCount() const;
+
+    // Most frequent first.
+    std::vector<CensusCount> getCounts() const;
+
+    // Such as "12 blocks, 4 blinkers, 1 unknown 23-cell object", or "no objects".
+    std::string format() const;
+};
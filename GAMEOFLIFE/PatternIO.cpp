@@ -0,0 +1,364 @@
+#include "PatternIO.h"
+#include <cctype>
+#include <fstream>
+#include <vector>
+#include <algorithm>
+
+// Largest side of a board read from a file.
+static constexpr long long MAXPATTERNSIZE = 1 << 20;
+
+// Character stream over a file with a large buffer. peek()/next() return EOF
+// at the end of the file.
+class PatternReader {
+private:
+    std::vector<char> Buffer;
+    std::ifstream File;
+    std::streambuf* Stream;
+
+public:
+    static constexpr int END = std::char_traits<char>::eof();
+
+    explicit PatternReader(const std::string& path) : Buffer(1 << 16) {
+        File.rdbuf()->pubsetbuf(Buffer.data(), Buffer.size());
+        File.open(path, std::ios::binary);
+        Stream = File.rdbuf();
+    }
+
+    bool isOpen() const { return File.is_open(); }
+
+    int peek() { return Stream->sgetc(); }
+
+    int next() { return Stream->sbumpc(); }
+
+    void rewind() {
+        File.clear();
+        File.seekg(0);
+    }
+
+    void skipLine() {
+        int c;
+        while ((c = next()) != END and c != '\n');
+    }
+
+    void skipBlanks() {
+        while (peek() == ' ' or peek() == '\t')
+            next();
+    }
+
+    bool expect(char expected) {
+        skipBlanks();
+        if (peek() != expected)
+            return false;
+        next();
+        return true;
+    }
+
+    bool readInteger(long long& value) {
+        skipBlanks();
+        bool negative = peek() == '-';
+        if (negative or peek() == '+')
+            next();
+        if (peek() < '0' or peek() > '9')
+            return false;
+        value = 0;
+        while (peek() >= '0' and peek() <= '9')
+            value = std::min(value * 10 + (next() - '0'), MAXPATTERNSIZE * MAXPATTERNSIZE);
+        if (negative)
+            value = -value;
+        return true;
+    }
+};
+
+constexpr int PatternReader::END;
+
+// Output through one string, flushed to the file in large blocks.
+class PatternWriter {
+private:
+    std::ofstream File;
+    std::string Buffer;
+
+public:
+    explicit PatternWriter(const std::string& path) : File(path, std::ios::binary) {}
+
+    bool isOpen() const { return File.is_open(); }
+
+    void write(const std::string& text) {
+        Buffer += text;
+        if (Buffer.size() >= (1 << 16))
+            flush();
+    }
+
+    void flush() {
+        File.write(Buffer.data(), Buffer.size());
+        Buffer.clear();
+    }
+
+    // Writes the rest and closes the file. False if any write failed, a full
+    // disk included, which only shows up when the stream is flushed.
+    bool close() {
+        flush();
+        File.close();
+        return !File.fail();
+    }
+};
+
+static bool isLiveCell(int c) {
+    return c == 'O' or c == '*' or c == '@';
+}
+
+// First x >= from whose cell differs from value, or width if there is none.
+static int findCellChange(const uint64_t* words, int from, int width, bool value) {
+    uint64_t flip = value ? ~0ULL : 0;
+    int word = from >> 6;
+    uint64_t bits = (words[word] ^ flip) & (~0ULL << (from & 63));
+    while (bits == 0) {
+        word++;
+        if (word * 64 >= width)
+            return width;
+        bits = words[word] ^ flip;
+    }
+    return std::min(width, word * 64 + countTrailingZeros64(bits));
+}
+
+static bool readRLE(PatternReader& reader, BitBoard& board, std::string* rule) {
+    while (reader.peek() == '#' or reader.peek() == '\r' or reader.peek() == '\n')
+        reader.skipLine();
+    long long width, height;
+    if (!(reader.expect('x') and reader.expect('=') and reader.readInteger(width) and reader.expect(',') and
+          reader.expect('y') and reader.expect('=') and reader.readInteger(height)))
+        return false;
+    if (width < 1 or height < 1 or width > MAXPATTERNSIZE or height > MAXPATTERNSIZE)
+        return false;
+    // The rest of the line may hold ", rule = B3/S23".
+    std::string header;
+    int c;
+    while ((c = reader.next()) != PatternReader::END and c != '\n')
+        header += (char)c;
+    size_t ruleField = header.find("rule");
+    size_t equals = header.find('=', ruleField);
+    if (rule and ruleField != std::string::npos and equals != std::string::npos) {
+        size_t begin = header.find_first_not_of(" \t", equals + 1);
+        size_t end = header.find_last_not_of(" \t\r");
+        *rule = begin <= end and end != std::string::npos ? header.substr(begin, end - begin + 1) : "";
+    }
+    board = BitBoard((int)height, (int)width);
+    long long x = 0, y = 0, count = 0;
+    while ((c = reader.next()) != PatternReader::END and c != '!') {
+        if (c >= '0' and c <= '9') {
+            count = std::min(count * 10 + (c - '0'), MAXPATTERNSIZE);
+            continue;
+        }
+        long long run = std::max(count, 1LL);
+        count = 0;
+        if (c == '$') {
+            y += run;
+            x = 0;
+        }
+        else if (c == 'b' or c == '.')
+            x += run;
+        else if (c == '#')
+            reader.skipLine();
+        else if ((c >= 'a' and c <= 'z') or (c >= 'A' and c <= 'Z')) {
+            if (y < height and x < width)
+                board.setRun((int)x, (int)y, (int)std::min(run, width - x));
+            x += run;
+        }
+    }
+    return true;
+}
+
+static bool readLife106(PatternReader& reader, BitBoard& board) {
+    long long minX = MAXPATTERNSIZE, minY = MAXPATTERNSIZE, maxX = -MAXPATTERNSIZE, maxY = -MAXPATTERNSIZE;
+    for (int pass = 0; pass < 2; pass++) {
+        reader.rewind();
+        while (reader.peek() != PatternReader::END) {
+            long long x, y;
+            if (reader.peek() == '#' or !reader.readInteger(x)) {
+                reader.skipLine();
+                continue;
+            }
+            if (!reader.readInteger(y))
+                return false;
+            reader.skipLine();
+            if (pass == 0) {
+                minX = std::min(minX, x);
+                minY = std::min(minY, y);
+                maxX = std::max(maxX, x);
+                maxY = std::max(maxY, y);
+            }
+            else
+                board.set((int)(x - minX), (int)(y - minY), true);
+        }
+        if (pass == 0) {
+            if (maxX < minX) // no cells
+                minX = maxX = minY = maxY = 0;
+            if (maxX - minX >= MAXPATTERNSIZE or maxY - minY >= MAXPATTERNSIZE)
+                return false;
+            board = BitBoard((int)(maxY - minY + 1), (int)(maxX - minX + 1));
+        }
+    }
+    return true;
+}
+
+static bool readPlaintext(PatternReader& reader, BitBoard& board) {
+    long long width = 0, height = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        reader.rewind();
+        int y = 0;
+        while (reader.peek() != PatternReader::END) {
+            if (reader.peek() == '!') {
+                reader.skipLine();
+                continue;
+            }
+            int x = 0, runStart = -1;
+            int c;
+            while ((c = reader.next()) != PatternReader::END and c != '\n') {
+                if (c == '\r')
+                    continue;
+                if (pass == 1) {
+                    if (isLiveCell(c) and runStart < 0)
+                        runStart = x;
+                    else if (!isLiveCell(c) and runStart >= 0) {
+                        board.setRun(runStart, y, x - runStart);
+                        runStart = -1;
+                    }
+                }
+                x++;
+            }
+            if (pass == 1 and runStart >= 0)
+                board.setRun(runStart, y, x - runStart);
+            width = std::max(width, (long long)x);
+            y++;
+        }
+        if (pass == 0) {
+            height = y;
+            if (width < 1 or height < 1 or width > MAXPATTERNSIZE or height > MAXPATTERNSIZE)
+                return false;
+            board = BitBoard((int)height, (int)width);
+        }
+    }
+    return true;
+}
+
+static bool hasExtension(const std::string& path, const char* extension) {
+    size_t length = std::char_traits<char>::length(extension);
+    if (path.size() < length)
+        return false;
+    for (size_t i = 0; i < length; i++)
+        if (std::tolower((unsigned char)path[path.size() - length + i]) != extension[i])
+            return false;
+    return true;
+}
+
+PatternFormat getPatternFormat(const std::string& path) {
+    if (hasExtension(path, ".rle"))
+        return PatternFormat::RLE;
+    if (hasExtension(path, ".lif") or hasExtension(path, ".life"))
+        return PatternFormat::Life106;
+    return PatternFormat::Plaintext;
+}
+
+bool readPattern(const std::string& path, BitBoard& board, std::string* rule) {
+    if (rule)
+        rule->clear();
+    PatternReader reader(path);
+    if (!reader.isOpen())
+        return false;
+    PatternFormat format = getPatternFormat(path);
+    if (format == PatternFormat::Plaintext and !hasExtension(path, ".cells")) {
+        std::string header;
+        while (header.size() < 10 and reader.peek() != PatternReader::END and reader.peek() != '\n')
+            header += (char)reader.next();
+        if (header == "#Life 1.06")
+            format = PatternFormat::Life106;
+        else if (!header.empty() and (header[0] == '#' or header[0] == 'x'))
+            format = PatternFormat::RLE;
+        reader.rewind();
+    }
+    switch (format) {
+    case PatternFormat::RLE:
+        return readRLE(reader, board, rule);
+    case PatternFormat::Life106:
+        return readLife106(reader, board);
+    default:
+        return readPlaintext(reader, board);
+    }
+}
+
+static void writeRLE(PatternWriter& writer, const BitBoard& board, const std::string& rule) {
+    writer.write("x = " + std::to_string(board.getWidth()) + ", y = " + std::to_string(board.getHeight()) + ", rule = " + rule + "\n");
+    std::string line;
+    long long pendingRows = 0;
+    auto emit = [&](long long count, char tag) {
+        std::string token = (count > 1 ? std::to_string(count) : std::string()) + tag;
+        if (line.size() + token.size() > 70) {
+            writer.write(line + '\n');
+            line.clear();
+        }
+        line += token;
+    };
+    for (int y = 0; y < board.getHeight(); y++) {
+        const uint64_t* words = board.row(y);
+        int x = 0;
+        while (x < board.getWidth()) {
+            bool value = board.get(x, y);
+            int end = findCellChange(words, x, board.getWidth(), value);
+            if (!value and end == board.getWidth())
+                break; // trailing dead cells are implied
+            if (pendingRows > 0) {
+                emit(pendingRows, '$');
+                pendingRows = 0;
+            }
+            emit(end - x, value ? 'o' : 'b');
+            x = end;
+        }
+        pendingRows++;
+    }
+    emit(1, '!');
+    writer.write(line + '\n');
+}
+
+static void writeLife106(PatternWriter& writer, const BitBoard& board) {
+    writer.write("#Life 1.06\n");
+    for (int y = 0; y < board.getHeight(); y++) {
+        const uint64_t* words = board.row(y);
+        for (int w = 0; w < board.getWordsPerRow(); w++) {
+            for (uint64_t bits = words[w]; bits != 0; bits &= bits - 1)
+                writer.write(std::to_string(w * 64 + countTrailingZeros64(bits)) + ' ' + std::to_string(y) + '\n');
+        }
+    }
+}
+
+static void writePlaintext(PatternWriter& writer, const BitBoard& board) {
+    std::string line;
+    for (int y = 0; y < board.getHeight(); y++) {
+        line.assign(board.getWidth(), '.');
+        for (int x = 0; x < board.getWidth(); x++)
+            if (board.get(x, y))
+                line[x] = 'O';
+        line += '\n';
+        writer.write(line);
+    }
+}
+
+bool writePattern(const std::string& path, const BitBoard& board, const std::string& rule) {
+    return writePattern(path, board, getPatternFormat(path), rule);
+}
+
+bool writePattern(const std::string& path, const BitBoard& board, PatternFormat format, const std::string& rule) {
+    PatternWriter writer(path);
+    if (!writer.isOpen())
+        return false;
+    switch (format) {
+    case PatternFormat::RLE:
+        writeRLE(writer, board, rule);
+        break;
+    case PatternFormat::Life106:
+        writeLife106(writer, board);
+        break;
+    default:
+        writePlaintext(writer, board);
+        break;
+    }
+    return writer.close();
+}
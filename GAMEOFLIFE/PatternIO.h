@@ -0,0 +1,27 @@
+#pragma once
+#include <string>
+#include "BitBoard.h"
+
+// Pattern files:
+//   RLE (.rle)         - "x = W, y = H" header, then runs like 3o2b$ ending with '!'
+//   Life 1.06 (.lif)   - "#Life 1.06", then one "x y" pair per live cell
+//   Plaintext (.cells) - one line per row, 'O' live and '.' dead, '!' comments
+// Files are streamed through a fixed buffer and runs are decoded straight into
+// the words of the board, so multi-megabyte patterns need no per-cell storage.
+enum class PatternFormat { Plaintext, RLE, Life106 };
+
+// Format by file extension, plaintext when the extension is not known.
+PatternFormat getPatternFormat(const std::string& path);
+
+// Reads a pattern into a board of its own size. For RLE that is the size from
+// the header; for the other formats, the bounding box of the cells. Files
+// without a known extension are recognized by their first line. The rule of
+// an RLE header goes into rule when given; it is left empty for the formats
+// that do not store one.
+bool readPattern(const std::string& path, BitBoard& board, std::string* rule = nullptr);
+
+// Writes the board in the format given by the extension of the path. Only RLE
+// records the rule.
+bool writePattern(const std::string& path, const BitBoard& board, const std::string& rule = "B3/S23");
+
+bool writePattern(const std::string& path, const BitBoard& board, PatternFormat format, const std::string& rule = "B3/S23");
@@ -0,0 +1,94 @@
+#include "PopulationPyramid.h"
+#include <algorithm>
+
+constexpr int PopulationPyramid::TILELEVEL;
+
+// Population of each byte of the word, in that byte.
+static uint64_t countBytes(uint64_t word) {
+    word = word - ((word >> 1) & 0x5555555555555555ULL);
+    word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+    return (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+}
+
+void PopulationPyramid::resize(int height, int width) {
+    Width = width;
+    Height = height;
+    LevelWidth.assign(1, (width + 63) / 64 * 8);
+    LevelHeight.assign(1, (height + 7) / 8);
+    Blocks.assign((size_t)LevelWidth[0] * LevelHeight[0], 0);
+    Levels.clear();
+    while (getLevelCount() <= TILELEVEL or LevelWidth.back() > 1 or LevelHeight.back() > 1) {
+        LevelWidth.push_back((LevelWidth.back() + 1) / 2);
+        LevelHeight.push_back((LevelHeight.back() + 1) / 2);
+        Levels.push_back(std::vector<uint32_t>((size_t)LevelWidth.back() * LevelHeight.back(), 0));
+    }
+}
+
+uint32_t PopulationPyramid::getChild(int level, int x, int y) const {
+    if (x >= LevelWidth[level] or y >= LevelHeight[level])
+        return 0;
+    return getCount(level, x, y);
+}
+
+void PopulationPyramid::recount(int level, int x, int y) {
+    Levels[level - 1][(size_t)y * LevelWidth[level] + x] = getChild(level - 1, 2 * x, 2 * y) + getChild(level - 1, 2 * x + 1, 2 * y) +
+                                                          getChild(level - 1, 2 * x, 2 * y + 1) + getChild(level - 1, 2 * x + 1, 2 * y + 1);
+}
+
+void PopulationPyramid::rebuild(const BitBoard& board) {
+    if (board.getWidth() != Width or board.getHeight() != Height)
+        resize(board.getHeight(), board.getWidth());
+    for (int ty = 0; ty < LevelHeight[TILELEVEL]; ty++)
+        for (int tx = 0; tx < LevelWidth[TILELEVEL]; tx++)
+            updateTile(board, tx, ty);
+    for (int level = TILELEVEL + 1; level < getLevelCount(); level++)
+        for (int y = 0; y < LevelHeight[level]; y++)
+            for (int x = 0; x < LevelWidth[level]; x++)
+                recount(level, x, y);
+}
+
+void PopulationPyramid::updateTile(const BitBoard& board, int tx, int ty) {
+    int blockRowEnd = std::min(LevelHeight[0], (ty + 1) * 8);
+    for (int by = ty * 8; by < blockRowEnd; by++) {
+        uint64_t counts = 0;
+        for (int y = by * 8; y < std::min(Height, by * 8 + 8); y++)
+            counts += countBytes(board.row(y)[tx]);
+        uint8_t* target = &Blocks[(size_t)by * LevelWidth[0] + tx * 8];
+        for (int b = 0; b < 8; b++)
+            target[b] = (uint8_t)(counts >> (8 * b));
+    }
+    for (int level = 1; level <= TILELEVEL; level++) {
+        int span = 1 << (TILELEVEL - level);
+        int yEnd = std::min(LevelHeight[level], (ty + 1) * span);
+        int xEnd = std::min(LevelWidth[level], (tx + 1) * span);
+        for (int y = ty * span; y < yEnd; y++)
+            for (int x = tx * span; x < xEnd; x++)
+                recount(level, x, y);
+    }
+}
+
+void PopulationPyramid::propagate(const std::vector<uint8_t>& changedTiles, int tilesX, int tilesY) {
+    std::vector<uint8_t> changed = changedTiles;
+    int width = tilesX, height = tilesY;
+    for (int level = TILELEVEL + 1; level < getLevelCount(); level++) {
+        std::vector<uint8_t> parents((size_t)LevelWidth[level] * LevelHeight[level], 0);
+        for (int y = 0; y < height; y++)
+            for (int x = 0; x < width; x++)
+                if (changed[(size_t)y * width + x])
+                    parents[(size_t)(y / 2) * LevelWidth[level] + x / 2] = 1;
+        width = LevelWidth[level];
+        height = LevelHeight[level];
+        for (int y = 0; y < height; y++)
+            for (int x = 0; x < width; x++)
+                if (parents[(size_t)y * width + x])
+                    recount(level, x, y);
+        changed.swap(parents);
+    }
+}
+
+size_t PopulationPyramid::getMemoryUsage() const {
+    size_t bytes = Blocks.capacity();
+    for (const auto& level : Levels)
+        bytes += level.capacity() * sizeof(uint32_t);
+    return bytes;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "BitBoard.h"
+
+// Live cell counts of square blocks at every power-of-two scale, for drawing
+// zoomed-out views without touching the cells. Level 0 counts 8x8 blocks, each
+// level above sums 2x2 blocks of the level below, so a block of level L covers
+// (8 << L) x (8 << L) cells. Level 3 blocks are exactly the 64x64 tiles of
+// GameOfLife: a changed tile updates levels 0-3 inside itself, which different
+// threads can do at the same time, and propagate() then updates the levels
+// above the changed tiles.
+class PopulationPyramid {
+private:
+    static constexpr int TILELEVEL = 3;
+
+    int Width, Height;
+    std::vector<uint8_t> Blocks; // level 0, one count per 8 cells of a word and 8 rows
+    std::vector<std::vector<uint32_t>> Levels; // level L at Levels[L - 1]
+    std::vector<int> LevelWidth, LevelHeight;
+
+    uint32_t getChild(int level, int x, int y) const;
+    void recount(int level, int x, int y);
+
+public:
+    PopulationPyramid() : Width(0), Height(0) {}
+
+    void resize(int height, int width);
+
+    void rebuild(const BitBoard& board);
+
+    // Recounts the blocks inside tile (tx, ty): 64 rows of word tx.
+    void updateTile(const BitBoard& board, int tx, int ty);
+
+    // Updates the levels above the tiles flagged in changedTiles (tilesX per row).
+    void propagate(const std::vector<uint8_t>& changedTiles, int tilesX, int tilesY);
+
+    int getLevelCount() const { return (int)Levels.size() + 1; }
+
+    int getLevelWidth(int level) const { return LevelWidth[level]; }
+
+    int getLevelHeight(int level) const { return LevelHeight[level]; }
+
+    // Population of block (x, y) of the level.
+    uint32_t getCount(int level, int x, int y) const {
+        return level == 0 ? Blocks[(size_t)y * LevelWidth[0] + x] : Levels[level - 1][(size_t)y * LevelWidth[level] + x];
+    }
+
+    size_t getMemoryUsage() const;
+};
@@ -0,0 +1,146 @@
+#include "SimulationThread.h"
+#include "FrameScheduler.h"
+
+void SimulationThread::start(GameOfLife& life, double generationInterval, double frameRate, bool paused) {
+    stop();
+    Life = &life;
+    GenerationInterval = generationInterval;
+    FrameRate = frameRate;
+    Paused = paused;
+    Resumed = Stopping = false;
+    PyramidWanted = false;
+    Edits.clear();
+    EditsPosted = 0;
+    // The first frame is published before the thread exists, so the caller
+    // has something to draw right away.
+    publish(false, 0);
+    Worker = std::thread(&SimulationThread::loop, this);
+}
+
+void SimulationThread::stop() {
+    if (!Worker.joinable())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(Mutex);
+        Stopping = true;
+    }
+    WakeUp.notify_one();
+    Worker.join();
+}
+
+void SimulationThread::post(std::function<void()> edit) {
+    {
+        std::lock_guard<std::mutex> lock(Mutex);
+        Edits.push_back(std::move(edit));
+    }
+    EditsPosted++;
+    WakeUp.notify_one();
+}
+
+void SimulationThread::setPaused(bool paused) {
+    {
+        std::lock_guard<std::mutex> lock(Mutex);
+        Resumed = Paused and !paused;
+        Paused = paused;
+    }
+    WakeUp.notify_one();
+}
+
+void SimulationThread::setPyramidWanted(bool wanted) {
+    post([this, wanted] { PyramidWanted = wanted; });
+}
+
+void SimulationThread::publish(bool isStable, long long editsApplied) {
+    LifeFrame& frame = Frames.getBack();
+    GameOfLife& life = *Life;
+    frame.Cells = life.getBoard();
+    frame.LifeLike = life.getRule().isLifeLike();
+    if (!frame.LifeLike) {
+        if (frame.Dying.getWidth() != life.getWidth() or frame.Dying.getHeight() != life.getHeight())
+            frame.Dying = BitBoard(life.getHeight(), life.getWidth());
+        else
+            frame.Dying.clear();
+        for (int y = 0; y < life.getHeight(); y++)
+            for (int x = 0; x < life.getWidth(); x++)
+                if (life.getCellState(x, y) >= 2)
+                    frame.Dying.set(x, y, true);
+    }
+    else if (frame.Dying.getWidth() > 0)
+        frame.Dying = BitBoard();
+    frame.Sequence = ++Published;
+    frame.Generation = life.getGeneration();
+    frame.Population = life.getPopulation();
+    frame.Period = life.getPeriod();
+    frame.CycleStart = life.getCycleStart();
+    frame.IsStable = isStable;
+    frame.EditsApplied = editsApplied;
+    frame.RuleName = life.getRuleName();
+    frame.ActiveKernel = life.getActiveKernel();
+    frame.ChunkCount = life.getChunkCount();
+    frame.ClusterProcesses = life.getClusterProcesses();
+    frame.KernelMismatches = life.getKernelMismatches();
+    frame.HasStats = life.getInstrumentation() != nullptr;
+    if (frame.HasStats)
+        frame.Stats = *life.getInstrumentation();
+    frame.HistoryFirst = life.getHistoryFirst();
+    frame.HistoryLast = life.getHistoryLast();
+    frame.HistoryBytes = life.getHistoryMemoryUsage();
+    frame.HasPyramid = PyramidWanted;
+    if (frame.HasPyramid)
+        frame.Pyramid = life.getPyramid();
+    // Once per settled board: the thread then waits for a key or an edit.
+    frame.Census.clear();
+    if (isStable) {
+        Census.clear();
+        life.takeCensus(Census);
+        frame.Census = Census.format();
+    }
+    Frames.publish();
+}
+
+// Edits are taken under the lock and run outside it. The lock is also taken
+// once per generation, uncontended unless somebody is posting right then.
+void SimulationThread::loop() {
+    FrameScheduler scheduler(GenerationInterval, FrameRate);
+    std::vector<std::function<void()>> edits;
+    long long editsApplied = 0;
+    bool isStable = false;
+    while (true) {
+        bool running;
+        {
+            std::unique_lock<std::mutex> lock(Mutex);
+            while (!Stopping and Edits.empty()) {
+                if (Resumed) {
+                    scheduler.restart();
+                    Resumed = false;
+                }
+                if (Paused or isStable)
+                    WakeUp.wait(lock);
+                else if (scheduler.isAsFastAsPossible() or scheduler.isGenerationDue())
+                    break;
+                else
+                    WakeUp.wait_until(lock, scheduler.getNextGeneration());
+            }
+            if (Stopping)
+                return;
+            edits.swap(Edits);
+            running = !Paused;
+        }
+        if (!edits.empty()) {
+            for (auto& edit : edits)
+                edit();
+            editsApplied += (long long)edits.size();
+            edits.clear();
+            isStable = false;
+            publish(false, editsApplied);
+        }
+        if (running and !isStable and (scheduler.isAsFastAsPossible() or scheduler.isGenerationDue())) {
+            isStable = Life->iterate() or Life->getPeriod() > 0;
+            scheduler.generationDone();
+            if (isStable or scheduler.isFrameDue()) {
+                publish(isStable, editsApplied);
+                scheduler.frameDone();
+            }
+        }
+    }
+}
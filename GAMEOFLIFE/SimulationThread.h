@@ -0,0 +1,104 @@
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "GameOfLife.h"
+#include "TripleBuffer.h"
+
+// Everything the user interface shows of one generation, copied out of the
+// simulation so it can be drawn while the next generations are computed.
+struct LifeFrame {
+    BitBoard Cells;
+    BitBoard Dying; // cells in state 2 and up, Generations rules only; empty otherwise
+    long long Sequence;
+    long long Generation, Population, Period, CycleStart;
+    bool IsStable;
+    long long EditsApplied;
+    std::string RuleName;
+    bool LifeLike;
+    KernelKind ActiveKernel;
+    size_t ChunkCount;
+    int ClusterProcesses; // worker processes stepping the strips, 0 when not in use
+    int KernelMismatches;
+    bool HasStats;
+    Instrumentation Stats; // of the simulation, when HasStats
+    long long HistoryFirst, HistoryLast; // -1 without history
+    size_t HistoryBytes;
+    std::string Census; // of a stable board, empty otherwise
+    bool HasPyramid;
+    PopulationPyramid Pyramid; // block counts of Cells, when HasPyramid
+
+    LifeFrame() : Sequence(0), Generation(0), Population(0), Period(0), CycleStart(0), IsStable(false), EditsApplied(0),
+                  LifeLike(true), ActiveKernel(KernelKind::Scalar), ChunkCount(0), ClusterProcesses(0), KernelMismatches(0), HasStats(false),
+                  HistoryFirst(-1), HistoryLast(-1), HistoryBytes(0), HasPyramid(false) {}
+
+    int getCellState(int x, int y) const {
+        return Cells.get(x, y) ? 1 : Dying.getWidth() > 0 and Dying.get(x, y) ? 2 : 0;
+    }
+};
+
+// Runs iterate() on its own thread, paced like FrameScheduler paces the game:
+// a generation every interval, or as fast as possible. At most frameRate times
+// a second, and whenever the board settles or an edit was applied, the state
+// is copied into a frame and handed over through a triple buffer, so a slow
+// terminal never holds up the simulation and a slow generation never holds up
+// the keyboard.
+//
+// While the thread runs, the GameOfLife belongs to it. Other threads change
+// it only through post(), whose edits run on the simulation thread between
+// two generations, in the order they were posted.
+class SimulationThread {
+private:
+    GameOfLife* Life;
+    std::thread Worker;
+    double GenerationInterval, FrameRate;
+
+    std::mutex Mutex;
+    std::condition_variable WakeUp;
+    std::vector<std::function<void()>> Edits;
+    bool Paused, Resumed, Stopping;
+
+    TripleBuffer<LifeFrame> Frames;
+    ObjectCensus Census;    // simulation thread
+    long long Published;    // simulation thread
+    bool PyramidWanted;     // simulation thread
+    long long EditsPosted;  // posting thread
+
+    void loop();
+    void publish(bool isStable, long long editsApplied);
+
+public:
+    SimulationThread() : Life(nullptr), GenerationInterval(0), FrameRate(30), Paused(false), Resumed(false), Stopping(false), Published(0), PyramidWanted(false), EditsPosted(0) {}
+
+    ~SimulationThread() { stop(); }
+
+    // A paused thread publishes a frame, then only applies edits.
+    void start(GameOfLife& life, double generationInterval, double frameRate, bool paused);
+
+    // Finishes the current generation and joins the thread; afterwards the
+    // GameOfLife may be used directly again.
+    void stop();
+
+    bool isRunning() const { return Worker.joinable(); }
+
+    void post(std::function<void()> edit);
+
+    // Resuming restarts the pacing, so no burst of overdue generations follows.
+    void setPaused(bool paused);
+
+    // Frames carry the population pyramid of the board while it is wanted.
+    // The simulation keeps it up to date tile by tile, publishing only copies
+    // it. Posted like an edit, so the next frame already has it.
+    void setPyramidWanted(bool wanted);
+
+    // Takes the newest published frame; false when there is none newer.
+    bool update() { return Frames.update(); }
+
+    const LifeFrame& getFrame() const { return Frames.getFront(); }
+
+    // The frame shows the effect of every edit posted so far.
+    bool isCurrent() const { return getFrame().EditsApplied == EditsPosted; }
+};
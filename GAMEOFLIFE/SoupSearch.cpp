@@ -0,0 +1,89 @@
+#include "SoupSearch.h"
+#include <algorithm>
+#include <atomic>
+
+void fillSoup(BitBoard& board, uint64_t seed, int soupSize) {
+    FastRandom random(seed);
+    board.clear();
+    int left = (board.getWidth() - soupSize) / 2;
+    int top = (board.getHeight() - soupSize) / 2;
+    for (int y = top; y < top + soupSize; y++) {
+        uint64_t* row = board.row(y);
+        for (int x = 0; x < soupSize; x += 64) {
+            int count = std::min(64, soupSize - x);
+            uint64_t bits = random.next() & (count == 64 ? ~0ULL : (1ULL << count) - 1);
+            int cell = left + x, shift = cell & 63;
+            row[cell >> 6] |= bits << shift;
+            if (shift + count > 64)
+                row[(cell >> 6) + 1] |= bits >> (64 - shift);
+        }
+    }
+}
+
+SoupSearch::SoupSearch(int height, int width, int soupSize, int threads) : Width(width), Height(height), SoupSize(std::min(soupSize, std::min(width, height))), MaxGenerations(10000) {
+    threads = std::max(1, threads);
+    for (int i = 0; i < threads; i++)
+        Lanes.emplace_back(new Lane(height, width));
+    if (threads > 1)
+        Pool.reset(new ThreadPool(threads));
+}
+
+void SoupSearch::setRule(const LifeRule& rule) {
+    for (auto& lane : Lanes)
+        lane->Life.setRule(rule);
+}
+
+void SoupSearch::setKernel(KernelKind kind) {
+    for (auto& lane : Lanes)
+        lane->Life.setKernel(kind);
+}
+
+SoupResult SoupSearch::runSoup(Lane& lane, uint64_t seed) {
+    fillSoup(lane.Soup, seed, SoupSize);
+    GameOfLife& life = lane.Life;
+    life.setBoard(lane.Soup);
+    life.setGeneration(0);
+    SoupResult result = { seed, 0, 0, 0 };
+    while (life.getGeneration() < MaxGenerations) {
+        bool isStable = life.iterate();
+        if (life.getPeriod() > 0) {
+            result.Period = life.getPeriod();
+            result.Generations = life.getCycleStart();
+            break;
+        }
+        // Rules without period detection only report a board that stopped changing.
+        if (isStable) {
+            result.Period = 1;
+            result.Generations = life.getGeneration() - 1;
+            break;
+        }
+    }
+    if (result.Period == 0)
+        result.Generations = life.getGeneration();
+    else
+        life.takeCensus(lane.Census);
+    result.Population = life.getPopulation();
+    return result;
+}
+
+// Each lane takes the next soup from a shared counter, so lanes that drew
+// short-lived soups simply run more of them.
+void SoupSearch::run(uint64_t firstSeed, int count, std::vector<SoupResult>& results) {
+    results.resize(count);
+    std::atomic<int> next(0);
+    auto runLane = [&](int laneIndex) {
+        Lane& lane = *Lanes[laneIndex];
+        for (int i = next++; i < count; i = next++)
+            results[i] = runSoup(lane, firstSeed + (uint64_t)i);
+    };
+    if (Pool)
+        Pool->parallelFor((int)Lanes.size(), runLane);
+    else
+        runLane(0);
+}
+
+void SoupSearch::getCensus(ObjectCensus& total) const {
+    total.clear();
+    for (const auto& lane : Lanes)
+        total.add(lane->Census);
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "GameOfLife.h"
+#include "FastRandom.h"
+
+// Outcome of one soup.
+struct SoupResult {
+    uint64_t Seed;
+    long long Generations; // until the cycle started, or the limit when it did not settle
+    long long Period;      // 0 - did not settle within the limit
+    long long Population;  // at the end
+};
+
+// Clears the board and fills a soupSize x soupSize square in its centre from
+// the seed, whole random words at a time.
+void fillSoup(BitBoard& board, uint64_t seed, int soupSize);
+
+// Runs many small soups side by side, one lane per thread. A lane keeps its
+// board and its single-threaded GameOfLife from soup to soup, so after the
+// first soup nothing but the hash history allocates. Soups run on the torus:
+// gliders that escape wrap around and are part of the final period.
+class SoupSearch {
+private:
+    struct Lane {
+        GameOfLife Life;
+        BitBoard Soup;
+        ObjectCensus Census; // of the settled soups of this lane
+
+        Lane(int height, int width) : Life(height, width), Soup(height, width) {}
+    };
+
+    int Width, Height, SoupSize;
+    long long MaxGenerations;
+    std::vector<std::unique_ptr<Lane>> Lanes;
+    std::unique_ptr<ThreadPool> Pool;
+
+    SoupResult runSoup(Lane& lane, uint64_t seed);
+
+public:
+    SoupSearch(int height, int width, int soupSize, int threads);
+
+    int getThreadCount() const { return (int)Lanes.size(); }
+
+    void setRule(const LifeRule& rule);
+
+    void setKernel(KernelKind kind);
+
+    // A soup still changing after this many generations counts as unsettled.
+    void setMaxGenerations(long long generations) { MaxGenerations = generations; }
+
+    // Runs the soups of seeds firstSeed ... firstSeed + count - 1; results[i]
+    // is the soup of seed firstSeed + i, whatever lane ran it.
+    void run(uint64_t firstSeed, int count, std::vector<SoupResult>& results);
+
+    // Objects of all the settled soups run so far.
+    void getCensus(ObjectCensus& total) const;
+};
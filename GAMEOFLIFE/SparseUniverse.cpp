@@ -0,0 +1,190 @@
+#include "SparseUniverse.h"
+#include <cstring>
+#include "LifeKernel.h"
+
+constexpr int SparseUniverse::CHUNKSIZE;
+constexpr uint32_t SparseUniverse::NONE;
+
+uint32_t SparseUniverse::findChunk(int32_t x, int32_t y) const {
+    auto found = Index.find(getKey(x, y));
+    return found == Index.end() ? NONE : found->second;
+}
+
+uint32_t SparseUniverse::getChunk(int32_t x, int32_t y) {
+    uint32_t index = findChunk(x, y);
+    if (index != NONE)
+        return index;
+    if (!FreeChunks.empty()) {
+        index = FreeChunks.back();
+        FreeChunks.pop_back();
+    }
+    else {
+        index = (uint32_t)Chunks.size();
+        Chunks.emplace_back();
+    }
+    Chunk& chunk = Chunks[index];
+    std::memset(chunk.Rows, 0, sizeof(chunk.Rows));
+    chunk.X = x;
+    chunk.Y = y;
+    chunk.Population = 0;
+    chunk.Changed = true;
+    chunk.Needed = false;
+    chunk.Free = false;
+    Index[getKey(x, y)] = index;
+    return index;
+}
+
+void SparseUniverse::freeChunk(uint32_t index) {
+    Chunks[index].Free = true;
+    Index.erase(getKey(Chunks[index].X, Chunks[index].Y));
+    FreeChunks.push_back(index);
+}
+
+// Makes sure the chunks the live cells on the edges of this one can spread to exist.
+void SparseUniverse::markNeeded(const Chunk& chunk) {
+    uint64_t any = 0;
+    for (int y = 0; y < CHUNKSIZE; y++)
+        any |= chunk.Rows[y];
+    uint64_t top = chunk.Rows[0], bottom = chunk.Rows[CHUNKSIZE - 1];
+    bool spills[3][3] = {
+        { (top & 1) != 0, top != 0, (top >> 63) != 0 },
+        { (any & 1) != 0, false, (any >> 63) != 0 },
+        { (bottom & 1) != 0, bottom != 0, (bottom >> 63) != 0 },
+    };
+    int32_t x = chunk.X, y = chunk.Y;
+    for (int dy = -1; dy <= 1; dy++)
+        for (int dx = -1; dx <= 1; dx++)
+            if (spills[dy + 1][dx + 1])
+                Chunks[getChunk(x + dx, y + dy)].Needed = true;
+}
+
+// Computes Next of one chunk from its 3x3 neighborhood. Returns whether it changed.
+bool SparseUniverse::stepChunk(uint32_t index) {
+    const uint32_t* around = &Neighbors[(size_t)index * 9];
+    Chunk& chunk = Chunks[index];
+    // Rows -1..64 of the chunk and of its west and east neighbors.
+    uint64_t mid[CHUNKSIZE + 2], west[CHUNKSIZE + 2], east[CHUNKSIZE + 2];
+    for (int column = 0; column < 3; column++) {
+        uint64_t* target = column == 0 ? west : column == 1 ? mid : east;
+        uint32_t north = around[column], centre = around[3 + column], south = around[6 + column];
+        target[0] = north == NONE ? 0 : Chunks[north].Rows[CHUNKSIZE - 1];
+        if (centre == NONE)
+            std::memset(target + 1, 0, CHUNKSIZE * sizeof(uint64_t));
+        else
+            std::memcpy(target + 1, Chunks[centre].Rows, CHUNKSIZE * sizeof(uint64_t));
+        target[CHUNKSIZE + 1] = south == NONE ? 0 : Chunks[south].Rows[0];
+    }
+    uint64_t westOf[CHUNKSIZE + 2], eastOf[CHUNKSIZE + 2];
+    for (int y = 0; y < CHUNKSIZE + 2; y++) {
+        westOf[y] = (mid[y] << 1) | (west[y] >> 63);
+        eastOf[y] = (mid[y] >> 1) | (east[y] << 63);
+    }
+    uint64_t changed = 0;
+    bool conway = Rule == CONWAYRULE;
+    for (int y = 1; y <= CHUNKSIZE; y++) {
+        uint64_t next = conway ? lifeWord(mid[y], westOf[y - 1], mid[y - 1], eastOf[y - 1], westOf[y], eastOf[y],
+                                          westOf[y + 1], mid[y + 1], eastOf[y + 1])
+                               : ruleWord(Rule.Birth, Rule.Survival, mid[y], westOf[y - 1], mid[y - 1], eastOf[y - 1],
+                                          westOf[y], eastOf[y], westOf[y + 1], mid[y + 1], eastOf[y + 1]);
+        chunk.Next[y - 1] = next;
+        changed |= next ^ mid[y];
+    }
+    return changed != 0;
+}
+
+void SparseUniverse::clear() {
+    Chunks.clear();
+    FreeChunks.clear();
+    Index.clear();
+    Generation = 0;
+    Population = 0;
+}
+
+void SparseUniverse::load(const BitBoard& board, uint64_t generation) {
+    clear();
+    Generation = generation;
+    for (int y = 0; y < board.getHeight(); y++) {
+        const uint64_t* row = board.row(y);
+        for (int w = 0; w < board.getWordsPerRow(); w++) {
+            if (row[w] == 0)
+                continue;
+            Chunk& chunk = Chunks[getChunk(w, y / CHUNKSIZE)];
+            chunk.Rows[y % CHUNKSIZE] = row[w];
+            chunk.Population += popcount64(row[w]);
+            Population += popcount64(row[w]);
+        }
+    }
+}
+
+void SparseUniverse::render(BitBoard& board) const {
+    board.clear();
+    int wordsPerRow = board.getWordsPerRow();
+    for (const Chunk& chunk : Chunks) {
+        if (chunk.Free or chunk.Population == 0 or chunk.X < 0 or chunk.Y < 0 or chunk.X >= wordsPerRow)
+            continue;
+        int yBegin = chunk.Y * CHUNKSIZE;
+        int yEnd = std::min(board.getHeight(), yBegin + CHUNKSIZE);
+        for (int y = yBegin; y < yEnd; y++)
+            board.row(y)[chunk.X] = chunk.Rows[y - yBegin];
+    }
+    for (int y = 0; y < board.getHeight() and wordsPerRow > 0; y++)
+        board.row(y)[wordsPerRow - 1] &= board.getLastWordMask();
+}
+
+bool SparseUniverse::step() {
+    for (Chunk& chunk : Chunks)
+        chunk.Needed = false;
+    size_t existing = Chunks.size();
+    for (size_t i = 0; i < existing; i++)
+        if (!Chunks[i].Free and Chunks[i].Population > 0)
+            markNeeded(Chunks[i]);
+
+    Neighbors.assign(Chunks.size() * 9, NONE);
+    for (size_t i = 0; i < Chunks.size(); i++) {
+        if (Chunks[i].Free)
+            continue;
+        for (int dy = -1; dy <= 1; dy++)
+            for (int dx = -1; dx <= 1; dx++)
+                Neighbors[i * 9 + (dy + 1) * 3 + dx + 1] = findChunk(Chunks[i].X + dx, Chunks[i].Y + dy);
+    }
+
+    // A chunk can only change if something in its neighborhood changed last time.
+    std::vector<uint8_t> active(Chunks.size(), 0), changed(Chunks.size(), 0);
+    for (size_t i = 0; i < Chunks.size(); i++) {
+        if (Chunks[i].Free)
+            continue;
+        for (int k = 0; k < 9; k++) {
+            uint32_t neighbor = Neighbors[i * 9 + k];
+            if (neighbor != NONE and Chunks[neighbor].Changed)
+                active[i] = 1;
+        }
+        if (active[i])
+            changed[i] = stepChunk((uint32_t)i);
+    }
+
+    bool anyChanged = false;
+    for (size_t i = 0; i < Chunks.size(); i++) {
+        Chunk& chunk = Chunks[i];
+        if (chunk.Free)
+            continue;
+        chunk.Changed = changed[i] != 0;
+        if (chunk.Changed) {
+            anyChanged = true;
+            std::memcpy(chunk.Rows, chunk.Next, sizeof(chunk.Rows));
+            Population -= chunk.Population;
+            chunk.Population = 0;
+            for (int y = 0; y < CHUNKSIZE; y++)
+                chunk.Population += popcount64(chunk.Rows[y]);
+            Population += chunk.Population;
+        }
+        else if (chunk.Population == 0 and !chunk.Needed)
+            freeChunk((uint32_t)i);
+    }
+    Generation++;
+    return !anyChanged;
+}
+
+size_t SparseUniverse::getMemoryUsage() const {
+    return Chunks.capacity() * sizeof(Chunk) + Neighbors.capacity() * sizeof(uint32_t) +
+           Index.size() * (sizeof(std::pair<const uint64_t, uint32_t>) + 2 * sizeof(void*));
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+#include "BitBoard.h"
+#include "LifeKernel.h"
+
+// Unbounded plane stored as 64x64 chunks in a hash map keyed by chunk
+// coordinates; chunk (cx, cy) holds cells [64cx, 64cx + 64) x [64cy, 64cy + 64),
+// one word per row with the same bit order as BitBoard. Only chunks with live
+// cells or next to them exist: a chunk is allocated when live cells reach the
+// edge of a neighbor and freed once it is empty and nothing spills into it.
+// A generation only recomputes the chunks whose neighborhood changed, so the
+// cost follows the live area rather than the bounding box.
+class SparseUniverse {
+private:
+    static constexpr int CHUNKSIZE = 64;
+    static constexpr uint32_t NONE = ~0u;
+
+    struct Chunk {
+        uint64_t Rows[CHUNKSIZE];
+        uint64_t Next[CHUNKSIZE];
+        int32_t X, Y;
+        int Population;
+        bool Changed; // changed in the last generation, or new
+        bool Needed;  // a neighbor has live cells on the shared edge
+        bool Free;
+    };
+
+    std::vector<Chunk> Chunks;
+    std::vector<uint32_t> FreeChunks;
+    std::unordered_map<uint64_t, uint32_t> Index;
+    std::vector<uint32_t> Neighbors; // 9 per chunk, filled by step()
+    uint64_t Generation;
+    uint64_t Population;
+    RuleMasks Rule;
+
+    static uint64_t getKey(int32_t x, int32_t y) { return ((uint64_t)(uint32_t)x << 32) | (uint32_t)y; }
+
+    uint32_t findChunk(int32_t x, int32_t y) const;
+    uint32_t getChunk(int32_t x, int32_t y);
+    void freeChunk(uint32_t index);
+    void markNeeded(const Chunk& chunk);
+    bool stepChunk(uint32_t index);
+
+public:
+    SparseUniverse() : Generation(0), Population(0), Rule(CONWAYRULE) {}
+
+    void clear();
+
+    // Any Life-like rule without B0, which would fill the unbounded plane.
+    void setRule(RuleMasks rule) { Rule = rule; }
+
+    // Replaces the plane with the cells of the board, cell (x, y) of the board
+    // becoming cell (x, y) of the plane.
+    void load(const BitBoard& board, uint64_t generation = 0);
+
+    // Writes the part of the plane covered by the board into it.
+    void render(BitBoard& board) const;
+
+    // Advances one generation. Returns true when nothing changed.
+    bool step();
+
+    uint64_t getGeneration() const { return Generation; }
+
+    uint64_t getPopulation() const { return Population; }
+
+    size_t getChunkCount() const { return Index.size(); }
+
+    size_t getMemoryUsage() const;
+};
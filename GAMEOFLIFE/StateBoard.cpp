@@ -0,0 +1,114 @@
+#include "StateBoard.h"
+
+constexpr int StateBoard::BANDROWS;
+
+void StateBoard::load(const BitBoard& board) {
+    Width = board.getWidth();
+    Height = board.getHeight();
+    Cells.assign((size_t)Width * Height, 0);
+    Next.assign(Cells.size(), 0);
+    RowSums.assign(Cells.size(), 0);
+    for (int y = 0; y < Height; y++)
+        for (int x = 0; x < Width; x++)
+            Cells[(size_t)y * Width + x] = board.get(x, y) ? 1 : 0;
+}
+
+void StateBoard::loadCells(int height, int width, const std::vector<uint8_t>& cells) {
+    Width = width;
+    Height = height;
+    Cells = cells;
+    Next.assign(Cells.size(), 0);
+    RowSums.assign(Cells.size(), 0);
+}
+
+void StateBoard::render(BitBoard& board) const {
+    board.clear();
+    for (int y = 0; y < Height; y++)
+        for (int x = 0; x < Width; x++)
+            if (Cells[(size_t)y * Width + x] == 1)
+                board.set(x, y, true);
+}
+
+// Sliding window along the row. A window wider than the board wraps around more
+// than once and counts such cells repeatedly, as the torus does.
+void StateBoard::sumRow(int y, int range) {
+    const uint8_t* row = &Cells[(size_t)y * Width];
+    uint16_t* sums = &RowSums[(size_t)y * Width];
+    int sum = 0;
+    for (int dx = -range; dx <= range; dx++)
+        sum += row[((dx % Width) + Width) % Width] == 1;
+    int entering = (range + 1) % Width;
+    int leaving = ((-range % Width) + Width) % Width;
+    for (int x = 0; x < Width; x++) {
+        sums[x] = (uint16_t)sum;
+        sum += (row[entering] == 1) - (row[leaving] == 1);
+        if (++entering == Width)
+            entering = 0;
+        if (++leaving == Width)
+            leaving = 0;
+    }
+}
+
+StepResult StateBoard::stepBand(int yBegin, int yEnd, const LifeRule& rule) {
+    int range = rule.Range;
+    std::vector<uint16_t> columnSums(Width, 0);
+    for (int dy = -range; dy <= range; dy++) {
+        const uint16_t* sums = &RowSums[(size_t)((((yBegin + dy) % Height) + Height) % Height) * Width];
+        for (int x = 0; x < Width; x++)
+            columnSums[x] += sums[x];
+    }
+    uint8_t dyingState = rule.States > 2 ? 2 : 0;
+    StepResult result = { 0, false };
+    for (int y = yBegin; y < yEnd; y++) {
+        const uint8_t* cells = &Cells[(size_t)y * Width];
+        uint8_t* next = &Next[(size_t)y * Width];
+        for (int x = 0; x < Width; x++) {
+            uint8_t state = cells[x];
+            int count = columnSums[x] - (!rule.CountSelf and state == 1);
+            uint8_t nextState;
+            if (state == 0)
+                nextState = rule.Birth[count];
+            else if (state == 1)
+                nextState = rule.Survival[count] ? 1 : dyingState;
+            else
+                nextState = state + 1 < rule.States ? state + 1 : 0;
+            next[x] = nextState;
+            result.Population += nextState == 1;
+            result.Changed = result.Changed or nextState != state;
+        }
+        const uint16_t* entering = &RowSums[(size_t)((y + range + 1) % Height) * Width];
+        const uint16_t* leaving = &RowSums[(size_t)((((y - range) % Height) + Height) % Height) * Width];
+        for (int x = 0; x < Width; x++)
+            columnSums[x] += entering[x] - leaving[x];
+    }
+    return result;
+}
+
+StepResult StateBoard::step(const LifeRule& rule, ThreadPool* pool) {
+    int bands = (Height + BANDROWS - 1) / BANDROWS;
+    std::vector<StepResult> results(bands);
+    auto sumBand = [&](int band) {
+        for (int y = band * BANDROWS; y < std::min(Height, (band + 1) * BANDROWS); y++)
+            sumRow(y, rule.Range);
+    };
+    auto stepBandTask = [&](int band) {
+        results[band] = stepBand(band * BANDROWS, std::min(Height, (band + 1) * BANDROWS), rule);
+    };
+    if (pool and pool->getThreadCount() > 1 and bands > 1) {
+        pool->parallelFor(bands, sumBand);
+        pool->parallelFor(bands, stepBandTask);
+    }
+    else {
+        for (int band = 0; band < bands; band++)
+            sumBand(band);
+        for (int band = 0; band < bands; band++)
+            stepBandTask(band);
+    }
+    Cells.swap(Next);
+    StepResult result = { 0, false };
+    for (const StepResult& band : results) {
+        result.Population += band.Population;
+        result.Changed = result.Changed or band.Changed;
+    }
+    return result;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "BitBoard.h"
+#include "LifeKernel.h"
+#include "LifeRule.h"
+#include "ThreadPool.h"
+
+// Toroidal board with one byte per cell, for the rules the bit-sliced kernels
+// do not cover: Generations (state 1 alive, 2..States-1 dying) and Larger than
+// Life. A generation counts the live cells around every cell with running sums,
+// first along the rows and then down the columns, so the cost does not grow
+// with the range; the next state is looked up in the Birth/Survival tables.
+class StateBoard {
+private:
+    // Rows per task; every band restarts its column sums from the row sums.
+    static constexpr int BANDROWS = 64;
+
+    int Width, Height;
+    std::vector<uint8_t> Cells, Next;
+    std::vector<uint16_t> RowSums; // live cells among the 2R+1 around each cell of its row
+
+    void sumRow(int y, int range);
+    StepResult stepBand(int yBegin, int yEnd, const LifeRule& rule);
+
+public:
+    StateBoard() : Width(0), Height(0) {}
+
+    // Live cells of the board in state 1, the rest dead.
+    void load(const BitBoard& board);
+
+    // Cells in state 1 into the board, which must have the same size.
+    void render(BitBoard& board) const;
+
+    uint8_t get(int x, int y) const { return Cells[(size_t)y * Width + x]; }
+
+    // The states of all cells, row after row.
+    const std::vector<uint8_t>& getCells() const { return Cells; }
+
+    // Takes the states of all cells of a height x width board, row after row.
+    void loadCells(int height, int width, const std::vector<uint8_t>& cells);
+
+    // Population counts the live cells only, not the dying ones.
+    StepResult step(const LifeRule& rule, ThreadPool* pool);
+
+    size_t getMemoryUsage() const { return Cells.capacity() + Next.capacity() + RowSums.capacity() * sizeof(uint16_t); }
+};
@@ -0,0 +1,312 @@
+#include "StripCluster.h"
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sched.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+struct StripCluster::Control {
+    alignas(64) std::atomic<int> Target; // generation the workers step to; -1 stops them
+};
+
+// Written by the worker of the strip only; one cache line each.
+struct alignas(64) StripCluster::StripState {
+    std::atomic<int> Done;      // generations stepped; Population and Changed are of the last one
+    std::atomic<int> HaloReady; // generations whose edge rows are in the ring
+    int Population;
+    int Changed;
+};
+
+static constexpr int TOP = 0, BOTTOM = 1;
+
+uint64_t* StripCluster::getBuffer(int strip, int parity) const {
+    size_t rows = (size_t)(FirstRows[strip + 1] - FirstRows[strip]) + 2;
+    return (uint64_t*)Regions[strip] + parity * rows * getStride();
+}
+
+// The ring slots, then the kernel counters, follow the two buffers.
+uint64_t* StripCluster::getEdge(int strip, int slot, int side) const {
+    return getBuffer(strip, 2) + (size_t)(slot * 2 + side) * WordsPerRow;
+}
+
+#if defined(__linux__)
+
+// Blocks while word holds value, for at most timeoutMillis. A short spin
+// first: the neighbors usually finish within microseconds of each other.
+static void waitWhileEqual(std::atomic<int>& word, int value, int timeoutMillis) {
+    for (int spin = 0; spin < 64; spin++) {
+        if (word.load(std::memory_order_acquire) != value)
+            return;
+        sched_yield();
+    }
+    timespec timeout = { timeoutMillis / 1000, (timeoutMillis % 1000) * 1000000L };
+    syscall(SYS_futex, (int*)&word, FUTEX_WAIT, value, &timeout, nullptr, 0);
+}
+
+static void wakeAll(std::atomic<int>& word) {
+    syscall(SYS_futex, (int*)&word, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+static int countNumaNodes() {
+    int count = 0;
+    char path[64];
+    while (snprintf(path, sizeof(path), "/sys/devices/system/node/node%d", count), access(path, F_OK) == 0)
+        count++;
+    return std::max(1, count);
+}
+
+// Pages of the region not touched yet come from the node, while it has memory left.
+static void placeOnNode(void* address, size_t size, int node) {
+    const int MPOL_PREFERRED = 1;
+    unsigned long nodeMask = 1UL << (node % 64);
+    syscall(SYS_mbind, address, size, MPOL_PREFERRED, &nodeMask, sizeof(nodeMask) * 8, 0);
+}
+
+// The CPUs of the node, from a list such as "0-3,8-11".
+static void runOnNode(int node) {
+    char path[64];
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+    char list[1024];
+    int file = open(path, O_RDONLY);
+    if (file < 0)
+        return;
+    ssize_t length = read(file, list, sizeof(list) - 1);
+    close(file);
+    if (length <= 0)
+        return;
+    list[length] = '\0';
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    int first, last, consumed;
+    for (const char* text = list; sscanf(text, "%d%n", &first, &consumed) == 1; ) {
+        text += consumed;
+        last = first;
+        if (*text == '-' and sscanf(text + 1, "%d%n", &last, &consumed) == 1)
+            text += 1 + consumed;
+        for (int cpu = first; cpu <= last and cpu < CPU_SETSIZE; cpu++)
+            CPU_SET(cpu, &cpus);
+        if (*text == ',')
+            text++;
+    }
+    if (CPU_COUNT(&cpus) > 0)
+        sched_setaffinity(0, sizeof(cpus), &cpus);
+}
+
+bool StripCluster::start(const BitBoard& board, int processes, KernelKind kind, RuleMasks rule, BoundaryKind boundary) {
+    stop();
+    Width = board.getWidth();
+    Height = board.getHeight();
+    WordsPerRow = board.getWordsPerRow();
+    Boundary = boundary;
+    int strips = std::max(1, std::min(processes, Height));
+    FirstRows.resize(strips + 1);
+    for (int k = 0; k <= strips; k++)
+        FirstRows[k] = (int)((long long)k * Height / strips);
+
+    // Each region: two buffers of the strip rows plus a halo row above and
+    // below, the four ring slots, and the word counters for the kernel.
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    auto roundUp = [page](size_t size) { return (size + page - 1) / page * page; };
+    size_t maxRows = (size_t)(Height + strips - 1) / strips;
+    size_t regionSize = roundUp((2 * (maxRows + 2) * getStride() + 5 * WordsPerRow) * sizeof(uint64_t) + sizeof(int) * WordsPerRow);
+    size_t headerSize = roundUp(sizeof(Control) + strips * sizeof(StripState));
+    MappingSize = headerSize + strips * regionSize;
+    void* mapping = mmap(nullptr, MappingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) {
+        MappingSize = 0;
+        return false;
+    }
+    Mapping = (uint8_t*)mapping;
+    Header = new (Mapping) Control();
+    Header->Target.store(0);
+    States = (StripState*)(Mapping + ((sizeof(Control) + alignof(StripState) - 1) / alignof(StripState) * alignof(StripState)));
+    for (int k = 0; k < strips; k++) {
+        new (&States[k]) StripState();
+        States[k].Done.store(0);
+        States[k].HaloReady.store(0);
+    }
+    NodeCount = countNumaNodes();
+    Regions.resize(strips);
+    for (int k = 0; k < strips; k++) {
+        Regions[k] = Mapping + headerSize + k * regionSize;
+        if (NodeCount > 1)
+            placeOnNode(Regions[k], regionSize, k % NodeCount);
+        int rows = FirstRows[k + 1] - FirstRows[k];
+        for (int y = 0; y < rows; y++)
+            memcpy(getBufferRow(k, 0, y + 1), board.row(FirstRows[k] + y), (size_t)WordsPerRow * sizeof(uint64_t));
+    }
+    Generations = 0;
+
+    StepSpanFunction stepRow = getStepSpanFunction(kind, rule);
+    int parent = (int)getpid();
+    for (int k = 0; k < strips; k++) {
+        pid_t worker = fork();
+        if (worker == 0) {
+            runWorker(k, stepRow, rule, parent);
+            _exit(0);
+        }
+        if (worker < 0) {
+            stop();
+            return false;
+        }
+        Workers.push_back((int)worker);
+    }
+    return true;
+}
+
+// In the forked process: nothing here allocates or touches what the parent's
+// other threads may have held locked at the time of the fork.
+void StripCluster::runWorker(int strip, StepSpanFunction stepRow, RuleMasks rule, int parent) {
+    if (NodeCount > 1)
+        runOnNode(strip % NodeCount);
+    int strips = (int)Regions.size();
+    int rows = FirstRows[strip + 1] - FirstRows[strip];
+    int neighbors[2] = { (strip - 1 + strips) % strips, (strip + 1) % strips };
+    StripState& state = States[strip];
+    uint64_t* changed = getEdge(strip, 2, TOP);
+    int* population = (int*)(changed + WordsPerRow);
+    int usedBits = Width - (WordsPerRow - 1) * 64;
+    uint64_t lastWordMask = usedBits == 64 ? ~0ULL : (1ULL << usedBits) - 1;
+    size_t rowBytes = (size_t)WordsPerRow * sizeof(uint64_t);
+    int done = 0;
+    while (true) {
+        int target = Header->Target.load(std::memory_order_acquire);
+        if (target < 0 or getppid() != parent)
+            return;
+        if (done >= target) {
+            waitWhileEqual(Header->Target, target, 1000);
+            continue;
+        }
+        int slot = done & 1;
+        memcpy(getEdge(strip, slot, TOP), getBufferRow(strip, slot, 1), rowBytes);
+        memcpy(getEdge(strip, slot, BOTTOM), getBufferRow(strip, slot, rows), rowBytes);
+        state.HaloReady.store(done + 1, std::memory_order_release);
+        wakeAll(state.HaloReady);
+        for (int neighbor : neighbors) {
+            int ready;
+            while ((ready = States[neighbor].HaloReady.load(std::memory_order_acquire)) <= done) {
+                if (Header->Target.load(std::memory_order_acquire) < 0 or getppid() != parent)
+                    return;
+                waitWhileEqual(States[neighbor].HaloReady, ready, 1000);
+            }
+        }
+        // Across the top and bottom edges of the board the halo rows follow the boundary.
+        uint64_t* halos[2] = { getBufferRow(strip, slot, 0), getBufferRow(strip, slot, rows + 1) };
+        for (int side : { TOP, BOTTOM }) {
+            const uint64_t* edge = getEdge(neighbors[side], slot, side == TOP ? BOTTOM : TOP);
+            bool acrossEdge = side == TOP ? strip == 0 : strip == strips - 1;
+            if (!acrossEdge or Boundary == BoundaryKind::Torus)
+                memcpy(halos[side], edge, rowBytes);
+            else if (Boundary == BoundaryKind::Klein)
+                mirrorRow(edge, halos[side], WordsPerRow, Width);
+            else
+                std::fill(halos[side], halos[side] + WordsPerRow, 0);
+        }
+        for (int y = 0; y <= rows + 1; y++)
+            fillRowGhosts(getBufferRow(strip, slot, y), WordsPerRow, Width, Boundary != BoundaryKind::Dead);
+        std::fill(changed, changed + WordsPerRow, 0);
+        std::fill(population, population + WordsPerRow, 0);
+        for (int y = 1; y <= rows; y++)
+            stepRow(getBufferRow(strip, slot, y - 1), getBufferRow(strip, slot, y), getBufferRow(strip, slot, y + 1),
+                    getBufferRow(strip, slot ^ 1, y), 0, WordsPerRow, WordsPerRow, Width, lastWordMask, changed, population, rule);
+        state.Population = 0;
+        state.Changed = 0;
+        for (int i = 0; i < WordsPerRow; i++) {
+            state.Population += population[i];
+            state.Changed |= changed[i] != 0;
+        }
+        state.Done.store(++done, std::memory_order_release);
+        wakeAll(state.Done);
+    }
+}
+
+// Any dead worker counts, not just this strip's: its neighbors wait for its
+// halo rows and would never finish either.
+bool StripCluster::waitDone(int strip, int generation) {
+    int done;
+    while ((done = States[strip].Done.load(std::memory_order_acquire)) < generation) {
+        waitWhileEqual(States[strip].Done, done, 100);
+        if (States[strip].Done.load(std::memory_order_acquire) >= generation)
+            break;
+        for (int worker : Workers)
+            if (waitpid(worker, nullptr, WNOHANG) != 0)
+                return false;
+    }
+    return true;
+}
+
+bool StripCluster::step(StepResult& result) {
+    if (!Mapping)
+        return false;
+    Generations++;
+    Header->Target.store(Generations, std::memory_order_release);
+    wakeAll(Header->Target);
+    result = { 0, false };
+    for (int k = 0; k < (int)Workers.size(); k++) {
+        if (!waitDone(k, Generations)) {
+            // Nobody writes the buffers of the generation before while this
+            // one is running, so they are still complete.
+            Generations--;
+            return false;
+        }
+        result.Population += States[k].Population;
+        result.Changed = result.Changed or States[k].Changed;
+    }
+    return true;
+}
+
+void StripCluster::stop() {
+    if (!Mapping)
+        return;
+    Header->Target.store(-1, std::memory_order_release);
+    wakeAll(Header->Target);
+    for (size_t k = 0; k < Workers.size(); k++)
+        wakeAll(States[k].HaloReady);
+    for (int worker : Workers)
+        waitpid(worker, nullptr, 0);
+    munmap(Mapping, MappingSize);
+    Mapping = nullptr;
+    MappingSize = 0;
+    Header = nullptr;
+    States = nullptr;
+    Workers.clear();
+    Regions.clear();
+}
+
+#else
+
+bool StripCluster::start(const BitBoard&, int, KernelKind, RuleMasks, BoundaryKind) {
+    return false;
+}
+
+void StripCluster::runWorker(int, StepSpanFunction, RuleMasks, int) {}
+
+bool StripCluster::waitDone(int, int) {
+    return false;
+}
+
+bool StripCluster::step(StepResult&) {
+    return false;
+}
+
+void StripCluster::stop() {}
+
+#endif
+
+void StripCluster::gather(BitBoard& board) const {
+    for (int k = 0; k < (int)Regions.size(); k++) {
+        int rows = FirstRows[k + 1] - FirstRows[k];
+        for (int y = 0; y < rows; y++)
+            memcpy(board.row(FirstRows[k] + y), getBufferRow(k, Generations & 1, y + 1), (size_t)WordsPerRow * sizeof(uint64_t));
+    }
+}
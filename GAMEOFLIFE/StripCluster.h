@@ -0,0 +1,77 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "BitBoard.h"
+#include "LifeKernel.h"
+
+// The board split into horizontal strips, each stepped by a worker process of
+// its own. Every strip lives in a shared memory region placed on one NUMA node
+// (round robin), and its worker runs on the CPUs of that node. Before each
+// generation a worker puts its first and last rows into a two-slot ring of
+// halo rows; its neighbors copy them into their own halo rows and step. A
+// neighbor can thus run at most one generation ahead, so two slots never
+// overwrite a row that is still to be read. The first and the last strip
+// take each other's rows or none, mirrored or not, as the boundary says.
+//
+// The coordinator, in the calling process, moves a shared target generation
+// forward and waits until every worker reports it done, collecting the
+// population and whether anything changed. Waiting is a futex on the shared
+// counters. Workers quit when told to or when the coordinating process is gone.
+//
+// Linux only: elsewhere start() fails and the caller steps the board itself.
+class StripCluster {
+private:
+    struct Control;
+    struct StripState;
+
+    uint8_t* Mapping;
+    size_t MappingSize;
+    Control* Header;
+    StripState* States;
+    std::vector<uint8_t*> Regions; // one per strip, page aligned
+    std::vector<int> FirstRows;    // strip k holds rows [FirstRows[k], FirstRows[k + 1])
+    std::vector<int> Workers;      // process ids
+    int Width, Height, WordsPerRow;
+    BoundaryKind Boundary;
+    int Generations, NodeCount;
+
+    // Buffer rows are laid out like those of BitBoard, ghost words included.
+    size_t getStride() const { return (size_t)WordsPerRow + 2; }
+    uint64_t* getBuffer(int strip, int parity) const;
+    uint64_t* getBufferRow(int strip, int parity, int y) const { return getBuffer(strip, parity) + (size_t)y * getStride() + 1; }
+    uint64_t* getEdge(int strip, int slot, int side) const;
+    void runWorker(int strip, StepSpanFunction stepRow, RuleMasks rule, int parent);
+    bool waitDone(int strip, int generation);
+
+public:
+    StripCluster() : Mapping(nullptr), MappingSize(0), Header(nullptr), States(nullptr), Width(0), Height(0), WordsPerRow(0), Boundary(BoundaryKind::Torus), Generations(0), NodeCount(0) {}
+
+    StripCluster(const StripCluster&) = delete;
+    StripCluster& operator=(const StripCluster&) = delete;
+
+    ~StripCluster() { stop(); }
+
+    // Starts up to processes workers (no more than there are rows) on the
+    // board. False when the system cannot, nothing is running then.
+    bool start(const BitBoard& board, int processes, KernelKind kind, RuleMasks rule, BoundaryKind boundary);
+
+    void stop();
+
+    bool isRunning() const { return Mapping != nullptr; }
+
+    int getProcessCount() const { return (int)Workers.size(); }
+
+    // NUMA nodes the strips are spread over, 1 on a machine without NUMA.
+    int getNodeCount() const { return NodeCount; }
+
+    // One generation on every strip. False when a worker died; the generation
+    // before can still be gathered then, until stop().
+    bool step(StepResult& result);
+
+    // Copies the latest generation of every strip into board, which must have
+    // the size of the board given to start().
+    void gather(BitBoard& board) const;
+
+    size_t getMemoryUsage() const { return MappingSize; }
+};
@@ -0,0 +1,66 @@
+#include "TerminalRenderer.h"
+#include <algorithm>
+
+constexpr int TerminalRenderer::MERGEGAP;
+constexpr chtype TerminalRenderer::UNKNOWN;
+
+void TerminalRenderer::resize(int rows, int cols) {
+    Rows = rows;
+    Cols = cols;
+    StaticLayer.assign((size_t)rows * cols, ' ');
+    Frame.assign((size_t)rows * cols, ' ');
+    Shadow.assign((size_t)rows * cols, UNKNOWN);
+}
+
+void TerminalRenderer::invalidate() {
+    std::fill(Shadow.begin(), Shadow.end(), UNKNOWN);
+}
+
+void TerminalRenderer::invalidateRows(int y, int count) {
+    int first = std::max(0, y);
+    int last = std::min(Rows, y + count);
+    for (int row = first; row < last; row++)
+        std::fill(Shadow.begin() + (size_t)row * Cols, Shadow.begin() + (size_t)(row + 1) * Cols, UNKNOWN);
+}
+
+void TerminalRenderer::clearStatic(chtype fill) {
+    std::fill(StaticLayer.begin(), StaticLayer.end(), fill);
+}
+
+void TerminalRenderer::beginFrame(int rows, int cols) {
+    FrameStart = std::chrono::steady_clock::now();
+    if (rows != Rows or cols != Cols)
+        resize(rows, cols);
+    std::copy(StaticLayer.begin(), StaticLayer.end(), Frame.begin());
+}
+
+void TerminalRenderer::endFrame() {
+    int cells = 0, runs = 0;
+    for (int y = 0; y < Rows; y++) {
+        const chtype* frameRow = Frame.data() + (size_t)y * Cols;
+        chtype* shadowRow = Shadow.data() + (size_t)y * Cols;
+        int x = 0;
+        while (x < Cols) {
+            if (frameRow[x] == shadowRow[x]) {
+                x++;
+                continue;
+            }
+            int runEnd = x + 1;
+            int lastChanged = x;
+            while (runEnd < Cols and runEnd - lastChanged <= MERGEGAP) {
+                if (frameRow[runEnd] != shadowRow[runEnd])
+                    lastChanged = runEnd;
+                runEnd++;
+            }
+            int length = lastChanged + 1 - x;
+            mvaddchnstr(y, x, frameRow + x, length);
+            std::copy(frameRow + x, frameRow + x + length, shadowRow + x);
+            cells += length;
+            runs++;
+            x = lastChanged + 1;
+        }
+    }
+    LastCellsEmitted = cells;
+    LastRunsEmitted = runs;
+    LastFrameMicros = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - FrameStart).count();
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <curses.h>
+#include <chrono>
+#include <vector>
+
+// Differential renderer for stdscr. A frame is composed in memory on top of a
+// static layer (background and border, built once per screen), then only the
+// cells that differ from the previous frame are handed to curses. Changed
+// cells are written in runs with mvaddchnstr(); every chtype carries its own
+// attributes, so no attron/attroff toggling happens per character.
+class TerminalRenderer {
+private:
+    // Runs separated by at most this many unchanged cells are merged into one
+    // write, which is cheaper than another cursor move.
+    static constexpr int MERGEGAP = 4;
+    static constexpr chtype UNKNOWN = ~(chtype)0;
+
+    int Rows, Cols;
+    std::vector<chtype> StaticLayer;
+    std::vector<chtype> Frame;
+    std::vector<chtype> Shadow;
+    std::chrono::steady_clock::time_point FrameStart;
+    long long LastFrameMicros;
+    int LastCellsEmitted, LastRunsEmitted;
+
+    bool isInside(int y, int x) const { return y >= 0 and x >= 0 and y < Rows and x < Cols; }
+
+public:
+    TerminalRenderer() : Rows(0), Cols(0), LastFrameMicros(0), LastCellsEmitted(0), LastRunsEmitted(0) {}
+
+    void resize(int rows, int cols);
+
+    // Forgets what is on the terminal, so the next frame is emitted in full.
+    // Needed after clear() or after anything else drew over the whole screen.
+    void invalidate();
+
+    // Same for rows that other code printed text over.
+    void invalidateRows(int y, int count);
+
+    void clearStatic(chtype fill);
+
+    void putStatic(int y, int x, chtype cell) {
+        if (isInside(y, x))
+            StaticLayer[y * Cols + x] = cell;
+    }
+
+    // Starts a frame as a copy of the static layer, resizing to the current terminal.
+    void beginFrame(int rows, int cols);
+
+    void put(int y, int x, chtype cell) {
+        if (isInside(y, x))
+            Frame[y * Cols + x] = cell;
+    }
+
+    void putText(int y, int x, const char* text, chtype attributes) {
+        for (; *text != '\0'; text++, x++)
+            put(y, x, (unsigned char)*text | attributes);
+    }
+
+    void endFrame();
+
+    long long getLastFrameMicros() const { return LastFrameMicros; }
+
+    int getLastCellsEmitted() const { return LastCellsEmitted; }
+
+    int getLastRunsEmitted() const { return LastRunsEmitted; }
+};
@@ -0,0 +1,487 @@
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "GameOfLife.h"
+#include "FastRandom.h"
+#include "PatternIO.h"
+#include "Checkpoint.h"
+#include "AnimationExport.h"
+
+// Checks of the steppers against a naive reference, of the file formats
+// against themselves and of the features on small known boards, run by ctest:
+//
+//   gameoflife-tests [temporary directory]
+//
+// Every failure is printed; the exit code is the number of failed checks.
+
+static int FAILURES = 0;
+
+static void check(bool passed, const char* what, const std::string& detail) {
+    if (passed)
+        return;
+    std::printf("FAILED %s: %s\n", what, detail.c_str());
+    FAILURES++;
+}
+
+static BitBoard makeSoup(int height, int width, uint64_t seed) {
+    FastRandom random(seed);
+    BitBoard board(height, width);
+    fillRandom(board, random);
+    return board;
+}
+
+// Cell (x, y) of the board continued past its edges as the boundary says.
+static bool getReferenceCell(const BitBoard& board, int x, int y, BoundaryKind boundary) {
+    int width = board.getWidth(), height = board.getHeight();
+    if (x < 0 or x >= width) {
+        if (boundary == BoundaryKind::Dead)
+            return false;
+        x = (x + width) % width;
+    }
+    if (y < 0 or y >= height) {
+        if (boundary == BoundaryKind::Dead or boundary == BoundaryKind::Cylinder)
+            return false;
+        if (boundary == BoundaryKind::Klein)
+            x = width - 1 - x;
+        y = (y + height) % height;
+    }
+    return board.get(x, y);
+}
+
+// One generation, one cell at a time.
+static BitBoard stepReference(const BitBoard& board, RuleMasks rule, BoundaryKind boundary) {
+    BitBoard next(board.getHeight(), board.getWidth());
+    for (int y = 0; y < board.getHeight(); y++)
+        for (int x = 0; x < board.getWidth(); x++) {
+            int neighborSum = 0;
+            for (int dy = -1; dy <= 1; dy++)
+                for (int dx = -1; dx <= 1; dx++)
+                    if (dx != 0 or dy != 0)
+                        neighborSum += getReferenceCell(board, x + dx, y + dy, boundary);
+            uint16_t mask = board.get(x, y) ? rule.Survival : rule.Birth;
+            next.set(x, y, (mask >> neighborSum) & 1);
+        }
+    return next;
+}
+
+// One generation of a rule with dying states or a larger range on the torus,
+// one cell at a time: cells are states (see GameOfLife::getCellState()) row
+// after row.
+static std::vector<uint8_t> stepStatesReference(const std::vector<uint8_t>& cells, int height, int width, const LifeRule& rule) {
+    std::vector<uint8_t> next(cells.size());
+    for (int y = 0; y < height; y++)
+        for (int x = 0; x < width; x++) {
+            int count = 0;
+            for (int dy = -rule.Range; dy <= rule.Range; dy++)
+                for (int dx = -rule.Range; dx <= rule.Range; dx++)
+                    if (dx != 0 or dy != 0 or rule.CountSelf)
+                        count += cells[(size_t)((y + dy + height) % height) * width + (x + dx + width) % width] == 1;
+            uint8_t state = cells[(size_t)y * width + x];
+            uint8_t nextState;
+            if (state == 0)
+                nextState = rule.Birth[count] ? 1 : 0;
+            else if (state == 1)
+                nextState = rule.Survival[count] ? 1 : (rule.States > 2 ? 2 : 0);
+            else
+                nextState = state + 1 < rule.States ? state + 1 : 0;
+            next[(size_t)y * width + x] = nextState;
+        }
+    return next;
+}
+
+static std::string describe(int width, int height, BoundaryKind boundary, KernelKind kernel, int threads, int generation) {
+    char text[160];
+    std::snprintf(text, sizeof(text), "%dx%d %s, kernel %s, %d threads, generation %d", width, height,
+                  getBoundaryName(boundary), getKernelName(kernel), threads, generation);
+    return text;
+}
+
+// Every kernel the CPU has, serial and on the pool, for every boundary and
+// board widths around the word size, against the reference. The cross-check
+// also steps each generation with the scalar kernel.
+static void testAgainstReference() {
+    static const int SIZES[][2] = { { 1, 1 }, { 5, 3 }, { 64, 64 }, { 65, 70 }, { 130, 200 }, { 257, 90 } };
+    static const RuleMasks HIGHLIFE = { countMask("36"), countMask("23") };
+    static constexpr int GENERATIONS = 60;
+    uint64_t seed = 1;
+    for (const auto& size : SIZES)
+        for (int b = 0; b < 4; b++)
+            for (int k = 0; k < 4; k++)
+                for (int threads : { 1, 3 }) {
+                    BoundaryKind boundary = (BoundaryKind)b;
+                    KernelKind kernel = (KernelKind)k;
+                    if (!isKernelSupported(kernel))
+                        continue;
+                    BitBoard reference = makeSoup(size[1], size[0], seed++);
+                    GameOfLife life(size[1], size[0]);
+                    life.setBoard(reference);
+                    life.setBoundary(boundary);
+                    life.setKernel(kernel);
+                    life.setThreadCount(threads);
+                    life.setCrossCheck(true);
+                    for (int generation = 1; generation <= GENERATIONS; generation++) {
+                        life.iterate();
+                        reference = stepReference(reference, CONWAYRULE, boundary);
+                        if (!(reference == life.getBoard())) {
+                            check(false, "reference", describe(size[0], size[1], boundary, kernel, threads, generation));
+                            break;
+                        }
+                    }
+                    check(life.getKernelMismatches() == 0, "kernel cross-check", describe(size[0], size[1], boundary, kernel, threads, GENERATIONS));
+                }
+
+    BitBoard reference = makeSoup(90, 150, seed);
+    BitBoard board = reference;
+    BitBoard next(board.getHeight(), board.getWidth());
+    for (int generation = 1; generation <= GENERATIONS; generation++) {
+        stepBoard(board, next, KernelKind::Scalar, HIGHLIFE);
+        board.swap(next);
+        reference = stepReference(reference, HIGHLIFE, BoundaryKind::Torus);
+        check(reference == board, "HighLife", "generation " + std::to_string(generation));
+    }
+}
+
+// A Generations rule, a Larger than Life one and one that is both, serial and
+// on the pool, against the reference.
+static void testStateRules() {
+    static const char* const RULES[] = { "B2/S/C3", "R2,C0,M1,S5..9,B6..8,NM", "R3,C5,M0,S8..20,B10..14,NM" };
+    static const int SIZES[][2] = { { 50, 40 }, { 70, 150 } };
+    static constexpr int GENERATIONS = 30;
+    uint64_t seed = 101;
+    for (const char* name : RULES)
+        for (const auto& size : SIZES)
+            for (int threads : { 1, 3 }) {
+                LifeRule rule;
+                check(parseRule(name, rule), "rule", std::string("cannot parse ") + name);
+                int width = size[0], height = size[1];
+                BitBoard soup = makeSoup(height, width, seed++);
+                std::vector<uint8_t> reference((size_t)width * height);
+                for (int y = 0; y < height; y++)
+                    for (int x = 0; x < width; x++)
+                        reference[(size_t)y * width + x] = soup.get(x, y) ? 1 : 0;
+                GameOfLife life(height, width);
+                life.setBoard(soup);
+                life.setRule(rule);
+                life.setThreadCount(threads);
+                for (int generation = 1; generation <= GENERATIONS; generation++) {
+                    life.iterate();
+                    reference = stepStatesReference(reference, height, width, rule);
+                    bool same = true;
+                    long long population = 0;
+                    for (int y = 0; y < height; y++)
+                        for (int x = 0; x < width; x++) {
+                            same = same and life.getCellState(x, y) == reference[(size_t)y * width + x];
+                            population += reference[(size_t)y * width + x] == 1;
+                        }
+                    if (!same or life.getPopulation() != population) {
+                        check(false, name, std::to_string(width) + "x" + std::to_string(height) + ", " + std::to_string(threads) +
+                                           " threads, generation " + std::to_string(generation));
+                        break;
+                    }
+                }
+            }
+}
+
+// Rule names are written back the way they are documented; the other forms
+// come back in the canonical one.
+static void testRuleNames() {
+    static const char* const NAMES[][2] = {
+        { "B3/S23", "B3/S23" },
+        { "B36/S23", "B36/S23" },
+        { "B3678/S34678", "B3678/S34678" },
+        { "B2/S", "B2/S" },
+        { "B2/S/C3", "B2/S/C3" },
+        { "R5,C0,M1,S34..58,B34..45,NM", "R5,C0,M1,S34..58,B34..45,NM" },
+        { "R2,C4,M0,S3..8,B4..6,NM", "R2,C4,M0,S3..8,B4..6,NM" },
+        { "23/3", "B3/S23" },
+        { "/2/3", "B2/S/C3" },
+        { "B3S23", "B3/S23" },
+        { "b3/s23:T100,100", "B3/S23" },
+    };
+    for (const auto& name : NAMES) {
+        LifeRule rule;
+        bool parsed = parseRule(name[0], rule);
+        check(parsed, "rule name", std::string("cannot parse ") + name[0]);
+        check(!parsed or formatRule(rule) == name[1], "rule name", std::string(name[0]) + " gave " + formatRule(rule));
+    }
+    for (const char* invalid : { "", "B0/S23", "B9/S23", "R11,C0,M1,S1..2,B1..2,NM", "B3/S23/C1" }) {
+        LifeRule rule;
+        check(!parseRule(invalid, rule), "rule name", std::string("accepted ") + invalid);
+    }
+}
+
+// Threads and worker processes have to give exactly the serial board.
+static void testParallel() {
+    static constexpr int GENERATIONS = 300;
+    BitBoard soup = makeSoup(300, 500, 7);
+    GameOfLife serial(300, 500), threaded(300, 500), strips(300, 500);
+    for (GameOfLife* life : { &serial, &threaded, &strips }) {
+        life->setBoard(soup);
+        life->setBoundary(BoundaryKind::Klein);
+    }
+    threaded.setThreadCount(4);
+    strips.setProcessCount(3);
+    for (int generation = 1; generation <= GENERATIONS; generation++) {
+        serial.iterate();
+        threaded.iterate();
+        strips.iterate();
+    }
+    check(serial.getBoard() == threaded.getBoard(), "threads", "board differs from the serial one");
+    check(serial.getPopulation() == threaded.getPopulation(), "threads", "population differs from the serial one");
+    check(serial.getBoard() == strips.getBoard(), "processes", "board differs from the serial one");
+    check(serial.getPopulation() == strips.getPopulation(), "processes", "population differs from the serial one");
+}
+
+// Hashlife and the chunked plane step the same unbounded universe.
+static void testUnbounded() {
+    BitBoard soup = makeSoup(48, 48, 11);
+    GameOfLife hashLife(256, 256), plane(256, 256);
+    BitBoard board(256, 256);
+    for (int y = 0; y < soup.getHeight(); y++)
+        for (int x = 0; x < soup.getWidth(); x++)
+            board.set(104 + x, 104 + y, soup.get(x, y));
+    hashLife.setBoard(board);
+    plane.setBoard(board);
+    hashLife.setHashLifeStep(0);
+    plane.setUnbounded(true);
+    for (int generation = 1; generation <= 200; generation++) {
+        hashLife.iterate();
+        plane.iterate();
+    }
+    check(hashLife.getGeneration() == plane.getGeneration(), "unbounded", "generations differ");
+    check(hashLife.getPopulation() == plane.getPopulation(), "unbounded", "populations differ");
+    check(hashLife.getBoard() == plane.getBoard(), "unbounded", "windows differ");
+}
+
+static BitBoard makeBoard(int height, int width, const char* const rows[], int x0, int y0, BitBoard board = BitBoard()) {
+    if (board.getWidth() == 0)
+        board = BitBoard(height, width);
+    for (int y = 0; rows[y]; y++)
+        for (int x = 0; rows[y][x]; x++)
+            if (rows[y][x] == 'o')
+                board.set(x0 + x, y0 + y, true);
+    return board;
+}
+
+static const char* const BLINKER[] = { "ooo", nullptr };
+static const char* const BLOCK[] = { "oo", "oo", nullptr };
+static const char* const GLIDER[] = { ".o.", "..o", "ooo", nullptr };
+
+static void testPeriods() {
+    struct Case {
+        const char* Name;
+        const char* const* Rows;
+        long long Period;
+    };
+    static const Case CASES[] = { { "block", BLOCK, 1 }, { "blinker", BLINKER, 2 } };
+    for (const Case& test : CASES) {
+        GameOfLife life(20, 20);
+        life.setBoard(makeBoard(20, 20, test.Rows, 8, 8));
+        for (int generation = 1; generation <= 10 and life.getPeriod() == 0; generation++)
+            life.iterate();
+        check(life.getPeriod() == test.Period, "period", std::string(test.Name) + " gave " + std::to_string(life.getPeriod()));
+    }
+}
+
+// Seeking gives the board of a fresh run to that generation, back and forward
+// again, and stepping on from there continues that run.
+static void testHistory() {
+    BitBoard soup = makeSoup(64, 96, 13);
+    GameOfLife life(64, 96);
+    life.setBoard(soup);
+    life.setHistoryBudget(1 << 22);
+    for (int generation = 1; generation <= 100; generation++)
+        life.iterate();
+    auto freshRun = [&](long long generations) {
+        GameOfLife fresh(64, 96);
+        fresh.setBoard(soup);
+        for (long long generation = 1; generation <= generations; generation++)
+            fresh.iterate();
+        return fresh.getBoard();
+    };
+    for (long long target : { 37LL, 5LL, 80LL, 0LL }) {
+        long long reached = life.seekGeneration(target);
+        check(reached == target, "history", "seeking " + std::to_string(target) + " reached " + std::to_string(reached));
+        check(life.getGeneration() == reached and life.getBoard() == freshRun(reached), "history",
+              "board of generation " + std::to_string(target) + " differs");
+    }
+    life.seekGeneration(37);
+    life.iterate();
+    check(life.getGeneration() == 38 and life.getBoard() == freshRun(38), "history", "stepping on after seeking differs");
+}
+
+static uint32_t getBigEndian(const std::string& data, size_t offset) {
+    return (uint32_t)(uint8_t)data[offset] << 24 | (uint32_t)(uint8_t)data[offset + 1] << 16 |
+           (uint32_t)(uint8_t)data[offset + 2] << 8 | (uint8_t)data[offset + 3];
+}
+
+// Bit by bit, unlike the table of the writer.
+static uint32_t getCrc32(const std::string& data, size_t offset, size_t size) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = offset; i < offset + size; i++) {
+        crc ^= (uint8_t)data[i];
+        for (int bit = 0; bit < 8; bit++)
+            crc = crc & 1 ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+    }
+    return ~crc;
+}
+
+static std::string readFile(const std::string& path) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    std::string data;
+    if (!file)
+        return data;
+    char buffer[4096];
+    size_t read;
+    while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+        data.append(buffer, read);
+    std::fclose(file);
+    return data;
+}
+
+// Every chunk CRC verifies and the frame counts agree; the GIF has its
+// header, the screen size and the trailer.
+static void testAnimations(const std::string& directory) {
+    static constexpr int FRAMES = 12;
+    BitBoard board = makeSoup(50, 70, 17);
+    for (const char* extension : { ".png", ".gif" }) {
+        std::string path = directory + "/gameoflife-test" + extension;
+        AnimationWriter writer;
+        writer.setBlocking(true);
+        GameOfLife life(50, 70);
+        life.setBoard(board);
+        bool written = writer.open(path, 70, 50, 1, 2, 100);
+        for (int frame = 0; written and frame < FRAMES; frame++) {
+            written = writer.push(life.getBoard(), life.getGeneration());
+            life.iterate();
+        }
+        writer.finish();
+        written = writer.wait() and written;
+        check(written and writer.getFramesWritten() == FRAMES, "animation", "cannot write " + path);
+        std::string data = readFile(path);
+        if (getAnimationFormat(path) == AnimationFormat::Gif) {
+            check(data.compare(0, 6, "GIF89a") == 0, "GIF", "no header");
+            check(data.size() > 10 and (uint8_t)data[6] == 140 and (uint8_t)data[8] == 100, "GIF", "screen size differs");
+            check(!data.empty() and data.back() == ';', "GIF", "no trailer");
+        }
+        else {
+            check(data.compare(0, 8, "\x89PNG\r\n\x1a\n") == 0, "APNG", "no signature");
+            size_t offset = 8;
+            long long frameControls = 0, frameCount = -1;
+            std::string type;
+            while (offset + 12 <= data.size()) {
+                size_t size = getBigEndian(data, offset);
+                if (offset + 12 + size > data.size())
+                    break;
+                type = data.substr(offset + 4, 4);
+                check(getCrc32(data, offset + 4, size + 4) == getBigEndian(data, offset + 8 + size), "APNG", "CRC of " + type);
+                if (type == "acTL")
+                    frameCount = getBigEndian(data, offset + 8);
+                frameControls += type == "fcTL";
+                offset += 12 + size;
+            }
+            check(offset == data.size() and type == "IEND", "APNG", "chunks do not end with IEND");
+            check(frameCount == FRAMES and frameControls == FRAMES, "APNG", "frame count " + std::to_string(frameCount) +
+                                                                            ", " + std::to_string(frameControls) + " frame controls");
+        }
+        std::remove(path.c_str());
+    }
+
+    // An APNG without frames would have no image: the writer reports it.
+    std::string path = directory + "/gameoflife-test-empty.png";
+    AnimationWriter writer;
+    bool opened = writer.open(path, 70, 50, 1, 1, 100);
+    writer.finish();
+    check(opened and !writer.wait(), "APNG", "an empty animation was reported as written");
+    check(readFile(path).empty(), "APNG", "the empty animation was left behind");
+    std::remove(path.c_str());
+}
+
+static void testCensus() {
+    GameOfLife life(32, 32);
+    life.setBoard(makeBoard(32, 32, GLIDER, 20, 4, makeBoard(32, 32, BLOCK, 5, 5)));
+    ObjectCensus census;
+    life.takeCensus(census);
+    check(census.format() == "1 block, 1 glider", "census", census.format());
+}
+
+static void testPatternRoundTrips(const std::string& directory) {
+    static const char* const EXTENSIONS[] = { ".rle", ".lif", ".cells" };
+    BitBoard board = makeSoup(37, 101, 3);
+    for (const char* extension : EXTENSIONS) {
+        std::string path = directory + "/gameoflife-test" + extension;
+        BitBoard loaded;
+        std::string rule;
+        bool written = writePattern(path, board, "B36/S23");
+        check(written, "pattern write", path);
+        check(written and readPattern(path, loaded, &rule), "pattern read", path);
+        // Life 1.06 and plaintext files end at the last live cell.
+        loaded.resize(board.getHeight(), board.getWidth());
+        check(loaded == board, "pattern round trip", path);
+        if (getPatternFormat(path) == PatternFormat::RLE)
+            check(rule == "B36/S23", "pattern rule", path + " gave " + rule);
+        std::remove(path.c_str());
+    }
+}
+
+static void testCheckpointRoundTrips(const std::string& directory) {
+    BitBoard board = makeSoup(200, 333, 5);
+    for (int y = 64; y < 128; y++)
+        for (int x = 0; x < board.getWidth(); x++)
+            board.set(x, y, false); // empty tiles for the compressed form to skip
+    for (bool compress : { false, true }) {
+        std::string path = directory + "/gameoflife-test.ckpt";
+        CheckpointInfo info = { 123456789012LL, board.countPopulation(), "B3/S23" };
+        CheckpointInfo loadedInfo = { 0, 0, "" };
+        BitBoard loaded;
+        const char* what = compress ? "compressed checkpoint" : "checkpoint";
+        bool written = writeCheckpoint(path, board, info, compress);
+        check(written, what, "cannot write " + path);
+        check(written and isCheckpointFile(path), what, "not recognized");
+        check(written and readCheckpoint(path, loaded, loadedInfo), what, "cannot read " + path);
+        check(loaded == board, what, "board differs");
+        check(loadedInfo.Generation == info.Generation and loadedInfo.Population == info.Population and loadedInfo.Rule == info.Rule,
+              what, "header differs");
+        std::remove(path.c_str());
+    }
+
+    // A rule name longer than the 24 bytes of the first version, with the
+    // states of the dying cells.
+    std::string path = directory + "/gameoflife-test.ckpt";
+    LifeRule rule;
+    parseRule("B12345678/S012345678/C255", rule);
+    BitBoard soup = makeSoup(40, 70, 9);
+    GameOfLife life(40, 70);
+    life.setBoard(soup);
+    life.setRule(rule);
+    for (int generation = 1; generation <= 5; generation++)
+        life.iterate();
+    CheckpointInfo info = { life.getGeneration(), life.getPopulation(), life.getRuleName(), life.getCellStates() };
+    CheckpointInfo loadedInfo = { 0, 0, "" };
+    BitBoard loaded;
+    bool written = writeCheckpoint(path, life.getBoard(), info, true);
+    check(written, "long rule checkpoint", "cannot write " + path);
+    check(written and readCheckpoint(path, loaded, loadedInfo), "long rule checkpoint", "cannot read " + path);
+    check(loadedInfo.Rule == "B12345678/S012345678/C255", "long rule checkpoint", "rule " + loadedInfo.Rule);
+    check(!info.States.empty() and loadedInfo.States == info.States, "long rule checkpoint", "states differ");
+    check(loaded == life.getBoard(), "long rule checkpoint", "board differs");
+    std::remove(path.c_str());
+}
+
+int main(int argc, char* argv[]) {
+    std::string directory = argc > 1 ? argv[1] : ".";
+    testAgainstReference();
+    testStateRules();
+    testRuleNames();
+    testParallel();
+    testUnbounded();
+    testPeriods();
+    testHistory();
+    testCensus();
+    testPatternRoundTrips(directory);
+    testAnimations(directory);
+    testCheckpointRoundTrips(directory);
+    std::printf("%d failed\n", FAILURES);
+    return FAILURES;
+}
@@ -0,0 +1,124 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(int threads) : Task(nullptr), Round(0), Busy(0), Stopping(false) {
+    start(threads);
+}
+
+ThreadPool::~ThreadPool() {
+    stop();
+}
+
+void ThreadPool::start(int threads) {
+    if (threads < 1)
+        threads = 1;
+    // New workers start at round 0: a round left over from the workers before
+    // would wake them at once into a job that is long gone.
+    {
+        std::lock_guard<std::mutex> lock(Mutex);
+        Stopping = false;
+        Task = nullptr;
+        Round = 0;
+        Busy = 0;
+    }
+    for (int i = 0; i < threads; i++)
+        Queues.push_back(std::unique_ptr<TaskQueue>(new TaskQueue()));
+    for (int i = 0; i < threads - 1; i++)
+        Workers.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+
+void ThreadPool::stop() {
+    {
+        std::lock_guard<std::mutex> lock(Mutex);
+        Stopping = true;
+    }
+    WakeUp.notify_all();
+    for (auto& worker : Workers)
+        worker.join();
+    Workers.clear();
+    Queues.clear();
+}
+
+void ThreadPool::setThreadCount(int threads) {
+    std::lock_guard<std::mutex> jobLock(JobMutex);
+    if (threads == getThreadCount())
+        return;
+    stop();
+    start(threads);
+}
+
+bool ThreadPool::popTask(int queueIndex, int& task) {
+    TaskQueue& own = *Queues[queueIndex];
+    {
+        std::lock_guard<std::mutex> lock(own.Mutex);
+        if (!own.Tasks.empty()) {
+            task = own.Tasks.front();
+            own.Tasks.pop_front();
+            return true;
+        }
+    }
+    int queues = (int)Queues.size();
+    for (int offset = 1; offset < queues; offset++) {
+        TaskQueue& victim = *Queues[(queueIndex + offset) % queues];
+        std::lock_guard<std::mutex> lock(victim.Mutex);
+        if (!victim.Tasks.empty()) {
+            task = victim.Tasks.back();
+            victim.Tasks.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+// Queues are only refilled when a new job starts, so once every queue is
+// empty there is nothing left to do in the current round.
+void ThreadPool::runTasks(int queueIndex, const std::function<void(int)>& task) {
+    int index;
+    while (popTask(queueIndex, index))
+        task(index);
+}
+
+void ThreadPool::workerLoop(int queueIndex) {
+    uint64_t seenRound = 0;
+    while (true) {
+        const std::function<void(int)>* task;
+        {
+            std::unique_lock<std::mutex> lock(Mutex);
+            WakeUp.wait(lock, [&] { return Stopping or Round != seenRound; });
+            if (Stopping)
+                return;
+            seenRound = Round;
+            task = Task;
+        }
+        runTasks(queueIndex, *task);
+        {
+            std::lock_guard<std::mutex> lock(Mutex);
+            if (--Busy == 0)
+                Done.notify_all();
+        }
+    }
+}
+
+void ThreadPool::parallelFor(int count, const std::function<void(int)>& task) {
+    std::lock_guard<std::mutex> jobLock(JobMutex);
+    int queues = (int)Queues.size();
+    if (queues == 1 or count <= 1) {
+        for (int i = 0; i < count; i++)
+            task(i);
+        return;
+    }
+    for (int q = 0; q < queues; q++) {
+        std::lock_guard<std::mutex> lock(Queues[q]->Mutex);
+        for (int i = (int)((int64_t)count * q / queues); i < (int)((int64_t)count * (q + 1) / queues); i++)
+            Queues[q]->Tasks.push_back(i);
+    }
+    {
+        std::lock_guard<std::mutex> lock(Mutex);
+        Task = &task;
+        Busy = (int)Workers.size();
+        Round++;
+    }
+    WakeUp.notify_all();
+    runTasks(queues - 1, task);
+    std::unique_lock<std::mutex> lock(Mutex);
+    Done.wait(lock, [&] { return Busy == 0; });
+}
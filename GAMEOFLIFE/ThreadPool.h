@@ -0,0 +1,52 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent pool of worker threads. parallelFor() splits the task indices
+// into one queue per thread; a thread that runs out of work steals from the
+// back of the other queues. The calling thread takes part in the work too, so
+// a pool of N threads starts N - 1 workers.
+class ThreadPool {
+private:
+    struct TaskQueue {
+        std::mutex Mutex;
+        std::deque<int> Tasks;
+    };
+
+    std::vector<std::thread> Workers;
+    std::vector<std::unique_ptr<TaskQueue>> Queues;
+    std::mutex JobMutex;
+    std::mutex Mutex;
+    std::condition_variable WakeUp;
+    std::condition_variable Done;
+    const std::function<void(int)>* Task;
+    uint64_t Round;
+    int Busy;
+    bool Stopping;
+
+    bool popTask(int queueIndex, int& task);
+    void runTasks(int queueIndex, const std::function<void(int)>& task);
+    void workerLoop(int queueIndex);
+    void start(int threads);
+    void stop();
+
+public:
+    explicit ThreadPool(int threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int getThreadCount() const { return (int)Queues.size(); }
+
+    void setThreadCount(int threads);
+
+    // Runs task(i) for every i in [0, count) and returns once all of them finished.
+    void parallelFor(int count, const std::function<void(int)>& task);
+};
@@ -0,0 +1,41 @@
+#pragma once
+#include <atomic>
+
+// Lock-free handoff of values from one producer thread to one consumer thread.
+// The producer fills the back slot and publishes it, which swaps it with the
+// middle slot; the consumer swaps the middle slot with its front slot when a
+// newer value is there. Neither side ever waits for the other: the producer
+// overwrites values the consumer skipped, and the consumer keeps reading its
+// front slot until something newer arrives. Slots are reused, so values that
+// hold buffers keep their capacity.
+template <class T>
+class TripleBuffer {
+private:
+    static constexpr int FRESH = 4; // set in Middle when it holds an unread value
+    static constexpr int INDEX = 3;
+
+    T Slots[3];
+    std::atomic<int> Middle;
+    int Back, Front;
+
+public:
+    TripleBuffer() : Middle(1), Back(0), Front(2) {}
+
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    // Producer side.
+    T& getBack() { return Slots[Back]; }
+
+    void publish() { Back = Middle.exchange(Back | FRESH, std::memory_order_acq_rel) & INDEX; }
+
+    // Consumer side. Returns true when the front slot changed.
+    bool update() {
+        if (!(Middle.load(std::memory_order_relaxed) & FRESH))
+            return false;
+        Front = Middle.exchange(Front, std::memory_order_acq_rel) & INDEX;
+        return true;
+    }
+
+    const T& getFront() const { return Slots[Front]; }
+};